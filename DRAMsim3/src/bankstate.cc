@@ -2,11 +2,13 @@
 
 namespace dramsim3 {
 
-BankState::BankState(const Config& config, SimpleStats& simple_stats, int rank, int bank_group, int bank)
+BankState::BankState(const Config& config, SimpleStats& simple_stats,
+                     const BankTiming& bank_timing, int channel, int rank, int bank_group, int bank)
     :   config_(config),
         simple_stats_(simple_stats),
         state_(State::CLOSED),
-        cmd_timing_(static_cast<int>(CommandType::SIZE)),
+        bank_timing_(&bank_timing),
+        bank_id_(rank * config.banks + bank_group * config.banks_per_group + bank),
         open_row_(-1),
         row_hit_count_(0),
         rank_(rank),
@@ -16,43 +18,26 @@ BankState::BankState(const Config& config, SimpleStats& simple_stats, int rank,
         acts_counter_(0),
         ref_idx_(0),
         fgr_counter_(0),
-        prac_(config_.rows, 0),
-        max_prac_val_(0)
+        prac_(config_.rows),
+        max_prac_val_(0),
+        drfm_sampler_(std::max(config_.drfm_qsize, 0)),
+        mint_acts_(0),
+        mint_row_(0),
+        rng_(config.seed, static_cast<uint64_t>(channel) * config.ranks * config.banks + bank_id_)
 {
-    cmd_timing_[static_cast<int>(CommandType::READ)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::READ_PRECHARGE)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::WRITE)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::WRITE_PRECHARGE)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::ACTIVATE)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::PRECHARGE)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::REFRESH_BANK)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::REFsb)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::REFab)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::SREF_ENTER)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::SREF_EXIT)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::RFMsb)] = 0; // [RFM] Same Bank RFM
-    cmd_timing_[static_cast<int>(CommandType::RFMab)] = 0; // [RFM] All Bank RFM
-    cmd_timing_[static_cast<int>(CommandType::DRFMb)] = 0; // [DRFM] DRFM Bank
-    cmd_timing_[static_cast<int>(CommandType::DRFMsb)] = 0; // [DRFM] DRFM Same Bank
-    cmd_timing_[static_cast<int>(CommandType::DRFMab)] = 0; // [DRFM] DRFM All Bank
-    cmd_timing_[static_cast<int>(CommandType::PREab)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::PREsb)] = 0;
-
     last_cmd_ = Command();
 
     // [Stats]
     bank_identifier = std::to_string(rank_) + "." + std::to_string(bank_group_) + "." + std::to_string(bank_);
-    acts_stat_name_ = "acts." + bank_identifier;
-    simple_stats_.InitStat(acts_stat_name_, "counter", "ACTs Counter");
+    acts_stat_ = simple_stats_.InitCounter("acts." + bank_identifier, "ACTs Counter");
     simple_stats_.InitHistoStat("acts_per_row_per_trefw", "ACTs per row per tREFW", 0, 65, 65);
+    acts_per_row_stat_ = simple_stats_.GetHistoStatId("acts_per_row_per_trefw");
 
     // [DRFM]
     drfm_issued_ = false;
 
-    mitig_used_stat_ = "mitig_used." + bank_identifier;
-    mitig_wasted_stat_ = "mitig_wasted." + bank_identifier;
-    simple_stats_.InitStat(mitig_used_stat_, "counter", "Mitig Used Counter");
-    simple_stats_.InitStat(mitig_wasted_stat_, "counter", "Mitig Wasted Counter");
+    mitig_used_stat_ = simple_stats_.InitCounter("mitig_used." + bank_identifier, "Mitig Used Counter");
+    mitig_wasted_stat_ = simple_stats_.InitCounter("mitig_wasted." + bank_identifier, "Mitig Wasted Counter");
 
     if (config_.dream_mode == 1)
     {
@@ -66,31 +51,25 @@ BankState::BankState(const Config& config, SimpleStats& simple_stats, int rank,
     else if (config_.graphene_mode == 1)
     {
         uint64_t max_acts = config_.refchunks * config_.tREFI / (config_.tRAS + config_.tRP);
-        graphene_entries_ = max_acts / config_.graphene_th;
-        graphene_q_.reserve(graphene_entries_);
-        graphene_spill_counter_ = 0;
+        graphene_tracker_ = GrapheneTracker(max_acts / config_.graphene_th, config_.graphene_th);
 
-        graphene_spills_stat_ = "graphene_spills." + bank_identifier;
-        simple_stats_.InitStat(graphene_spills_stat_, "counter", "Graphene Spills Counter");
+        graphene_spills_stat_ = simple_stats_.InitCounter("graphene_spills." + bank_identifier, "Graphene Spills Counter");
 
-        graphene_resets_stat_ = "graphene_resets." + bank_identifier;
-        simple_stats_.InitStat(graphene_resets_stat_, "counter", "Graphene Resets Counter");
+        graphene_resets_stat_ = simple_stats_.InitCounter("graphene_resets." + bank_identifier, "Graphene Resets Counter");
     }
     else if (config_.hydra_mode == 1)
     {
         num_rows_per_gct_ = config_.rows / config_.hydra_gct_size;
         hydra_gct_.resize(config_.hydra_gct_size, 0);
         hydra_gct_valid_.resize(config_.hydra_gct_size, true);
-        hydra_counts_.resize(config_.rows, 0);
+        // only compared against hydra_th, any count from there on is alike
+        hydra_counts_ = RowCounters(config_.rows, std::max(config_.hydra_th, config_.hydra_gct_th));
 
-        hydra_resets_stat_ = "hydra_resets." + bank_identifier;
-        simple_stats_.InitStat(hydra_resets_stat_, "counter", "Hydra Resets Counter");
+        hydra_resets_stat_ = simple_stats_.InitCounter("hydra_resets." + bank_identifier, "Hydra Resets Counter");
     
-        hydra_gct_overflows_stat_ = "hydra_gct_overflows." + bank_identifier;
-        simple_stats_.InitStat(hydra_gct_overflows_stat_, "counter", "Hydra GCT Overflows Counter");
+        hydra_gct_overflows_stat_ = simple_stats_.InitCounter("hydra_gct_overflows." + bank_identifier, "Hydra GCT Overflows Counter");
 
-        hydra_aggressor_stat_ = "hydra_aggressor." + bank_identifier;
-        simple_stats_.InitStat(hydra_aggressor_stat_, "counter", "Hydra Victim Counter");
+        hydra_aggressor_stat_ = simple_stats_.InitCounter("hydra_aggressor." + bank_identifier, "Hydra Victim Counter");
     }
     else if (config_.moat_mode == 1)
     {
@@ -100,6 +79,19 @@ BankState::BankState(const Config& config, SimpleStats& simple_stats, int rank,
 
 
 Command BankState::GetReadyCommand(const Command& cmd, uint64_t clk) const {
+    CommandType required_type = RequiredCommand(cmd);
+    if (required_type != CommandType::SIZE)
+    {
+        if (clk >= bank_timing_->Get(required_type, bank_id_))
+        {
+            return Command(required_type, cmd.addr, cmd.hex_addr);
+        }
+
+    }
+    return Command();
+}
+
+CommandType BankState::RequiredCommand(const Command& cmd) const {
     CommandType required_type = CommandType::SIZE;
     int rfm_th = config_.rfm_policy ? config_.raammt : config_.raaimt;
 
@@ -208,16 +200,7 @@ Command BankState::GetReadyCommand(const Command& cmd, uint64_t clk) const {
             AbruptExit(__FILE__, __LINE__);
             break;
     }
-
-    if (required_type != CommandType::SIZE)
-    {
-        if (clk >= cmd_timing_[static_cast<int>(required_type)])
-        {
-            return Command(required_type, cmd.addr, cmd.hex_addr);
-        }
-
-    }
-    return Command();
+    return required_type;
 }
 
 bool BankState::IsInDRFM() const
@@ -305,13 +288,22 @@ void BankState::UpdateState(const Command& cmd, uint64_t clk) {
                         // [MOAT]
                         moat_refresh();
 
-                        // [PRAC]
-                        for (int i = 0; i < config_.rows_refreshed; i++)
+                        // [PRAC] the refreshed rows are contiguous, split
+                        // only where they wrap around
+                        for (int left = config_.rows_refreshed, idx = ref_idx_; left > 0; idx = 0)
                         {
-                            int idx = (ref_idx_ + i) % config_.rows;
-                            simple_stats_.AddValue("acts_per_row_per_trefw", prac_[idx]);
-                            max_prac_val_ = std::max<uint32_t>(max_prac_val_, prac_[idx]);
-                            prac_[idx] = 0;
+                            int num = std::min(left, config_.rows - idx);
+                            prac_.ResetRows(idx, num,
+                                [this](uint32_t val, uint64_t count) {
+                                    simple_stats_.AddValue(acts_per_row_stat_, val, count);
+                                    max_prac_val_ = std::max(max_prac_val_, val);
+                                },
+                                [this](const uint16_t* vals, int n) {
+                                    simple_stats_.AddValues(acts_per_row_stat_, vals, n);
+                                    uint32_t max_val = *std::max_element(vals, vals + n);
+                                    max_prac_val_ = std::max(max_prac_val_, max_val);
+                                });
+                            left -= num;
                         }
 
                         ref_idx_ = (ref_idx_ + config_.rows_refreshed) % config_.rows;
@@ -352,13 +344,13 @@ void BankState::UpdateState(const Command& cmd, uint64_t clk) {
 
                     // [Stats]
                     acts_counter_++;
-                    simple_stats_.Increment(acts_stat_name_);
+                    simple_stats_.Increment(acts_stat_);
 
                     // [RFM]
                     raa_ctr_++;
 
                     // [PRAC]                    
-                    prac_[open_row_]++;
+                    prac_.Increment(open_row_);
 
                     // [MOAT]
                     moat_act(open_row_);
@@ -417,12 +409,6 @@ void BankState::UpdateState(const Command& cmd, uint64_t clk) {
     return;
 }
 
-void BankState::UpdateTiming(CommandType cmd_type, uint64_t time) {
-    cmd_timing_[static_cast<int>(cmd_type)] =
-        std::max(cmd_timing_[static_cast<int>(cmd_type)], time);
-    return;
-}
-
 std::string BankState::StateToString(State state) const {
     switch (state) {
         case State::OPEN:
@@ -449,7 +435,7 @@ bool BankState::CheckAlert()
 {
     if (config_.moat_mode == 1)
     {
-        return (moat_max_prac_idx_ != -1 and prac_[moat_max_prac_idx_] > config_.moatth);
+        return (moat_max_prac_idx_ != -1 and prac_.Get(moat_max_prac_idx_) > config_.moatth);
     }
     return false;
 }
@@ -458,19 +444,15 @@ bool BankState::IsSamplerFull()
 {
     if (config_.drfm_mode == 0) return false;
 
-    // std::cout << bank_identifier << ".IsSamplerFull: " << drfm_q_.size() << " " << config_.drfm_qsize << std::endl;
-    if (drfm_q_.size() >= (uint32_t)config_.drfm_qsize)
+    // std::cout << bank_identifier << ".IsSamplerFull: " << drfm_sampler_.Size() << " " << config_.drfm_qsize << std::endl;
+    if (drfm_sampler_.Size() >= (uint32_t)config_.drfm_qsize)
     {
         return true;
     }
 
-    auto max_entry = std::max_element(drfm_q_.begin(), drfm_q_.end(), [] (const DRFM_Q_Entry& a, const DRFM_Q_Entry& b) {
-        return a.ctr < b.ctr;
-    });
-
-    if (max_entry != drfm_q_.end())
+    if (!drfm_sampler_.Empty())
     {
-        return max_entry->ctr >= config_.drfm_qth;
+        return drfm_sampler_.MaxCount() >= config_.drfm_qth;
     }
 
     return false;
@@ -502,39 +484,44 @@ bool BankState::PreACT(const Command& cmd)
 
 void BankState::drfm_post_act(uint32_t rowid)
 {
-    auto found = std::find_if(drfm_q_.begin(), drfm_q_.end(), [rowid](const DRFM_Q_Entry& entry) {
-        return entry.rowid == rowid;
-    });
-
-    if (found != drfm_q_.end())
-    {
-        found->ctr++;
-    }
+    drfm_sampler_.Bump(rowid);
 }
 
 void BankState::insert_drfm(uint32_t rowid)
 {
     if (config_.drfm_mode == 0) return;
 
-    drfm_q_.emplace_back(rowid, 0);
+    drfm_sampler_.Insert(rowid);
+}
+
+void BankState::insert_drfm(const uint32_t* rowids, int num)
+{
+    if (config_.drfm_mode == 0) return;
+
+    for (int i = 0; i < num; i++)
+    {
+        drfm_sampler_.Insert(rowids[i]);
+    }
 }
 
 void BankState::mint_preact(uint32_t rowid)
 {
     if (config_.mint_mode == 0) return;
 
-    mint_rows_.push_back(rowid);
-
-    if (mint_rows_.size() >= (uint32_t)config_.mint_window)
+    // the i-th ACT of the window replaces the pick with probability 1/i,
+    // so every ACT of the window ends up picked with the same probability
+    mint_acts_++;
+    if (rng_.Below(mint_acts_) == 0)
     {
-        // Pick a random row from mint_rows_
-        uint32_t idx = rand() % mint_rows_.size();
-        uint32_t select_rowid = mint_rows_[idx];
+        mint_row_ = rowid;
+    }
 
-        mint_rows_.clear();
+    if (mint_acts_ >= config_.mint_window)
+    {
+        mint_acts_ = 0;
 
-        assert(drfm_q_.size() <= config_.drfm_qsize);
-        drfm_q_.emplace_back(select_rowid, 0);
+        assert(drfm_sampler_.Size() <= config_.drfm_qsize);
+        drfm_sampler_.Insert(mint_row_);
     }
 }
 
@@ -543,11 +530,10 @@ void BankState::para_preact(uint32_t rowid)
     if (config_.para_mode == 0) return;
 
     double targ_prob = config_.para_prob;
-    double randval = static_cast<double>(rand() % (1 << 20)) / static_cast<double>(1 << 20);
-    if (randval < targ_prob)
+    if (rng_.Uniform() < targ_prob)
     {
-        assert(drfm_q_.size() <= config_.drfm_qsize);
-        drfm_q_.emplace_back(rowid, 0);
+        assert(drfm_sampler_.Size() <= config_.drfm_qsize);
+        drfm_sampler_.Insert(rowid);
     }
 
 }
@@ -556,66 +542,35 @@ void BankState::graphene_preact(uint32_t rowid)
 {
     if (config_.graphene_mode == 0) return;
 
-    auto found = std::find_if(graphene_q_.begin(), graphene_q_.end(), [rowid](const GRAPHENE_Q_Entry& entry) {
-        return entry.rowid == rowid;
-    });
-
-    if (found != graphene_q_.end())
+    if (!graphene_tracker_.Access(rowid))
     {
-        found->ctr++;
-    }
-    else
-    {
-        if (graphene_q_.size() < graphene_entries_)
-        {
-            graphene_q_.emplace_back(rowid, 1);
-        }
-        else
-        {
-            auto low_count_entry = std::find_if(graphene_q_.begin(), graphene_q_.end(), [this] (const GRAPHENE_Q_Entry& entry) {
-                return entry.ctr == graphene_spill_counter_;
-            });
-
-            if (low_count_entry != graphene_q_.end())
-            {
-                low_count_entry->rowid = rowid;
-                low_count_entry->ctr = graphene_spill_counter_ + 1;
-            }
-            else
-            {
-                graphene_spill_counter_++;
-                simple_stats_.Increment(graphene_spills_stat_);
-            }
-        }
+        simple_stats_.Increment(graphene_spills_stat_);
     }
 
-    // max element in graphene_q_ is greater than or equal to graphene_th
-    auto found_tg = std::find_if(graphene_q_.begin(), graphene_q_.end(), [this] (const GRAPHENE_Q_Entry& entry) {
-        return entry.ctr >= config_.graphene_th;
-    });
+    // max element in the table is greater than or equal to graphene_th
+    int64_t rowid_tg = graphene_tracker_.FirstAboveThreshold();
 
-    if (found_tg != graphene_q_.end())
+    if (rowid_tg != -1)
     {
-        assert(drfm_q_.size() <= config_.drfm_qsize);
-        drfm_q_.emplace_back(found_tg->rowid, 0);
+        assert(drfm_sampler_.Size() <= config_.drfm_qsize);
+        drfm_sampler_.Insert(rowid_tg);
     }
 }
 
-int64_t BankState::hydra_check_rcc(const Command& cmd)
+bool BankState::hydra_uses_rcc(uint32_t rowid) const
 {
-    if (config_.hydra_mode == 0) return 0;
-    
-    uint32_t rowid = cmd.Row();
-    uint32_t gct_idx = rowid % config_.hydra_gct_size;
+    if (config_.hydra_mode == 0) return false;
 
-    if (hydra_gct_valid_[gct_idx])
-    {
-        return 0;
-    }
+    // rows of a group still counted in the GCT have no counter of their own
+    return !hydra_gct_valid_[rowid % config_.hydra_gct_size];
+}
 
-    uint64_t rcc_tag = config_.ResetColBits(cmd.hex_addr);
-    uint64_t rcc_set = config_.RemoveColBits(cmd.hex_addr);
-    return const_cast<LRUCache*>(&config_.hydra_rcc)->read(rcc_tag, rcc_set);
+void BankState::Checkpoint(StateIO& io)
+{
+    io(state_, last_cmd_, open_row_, row_hit_count_, raa_ctr_, acts_counter_,
+       ref_idx_, fgr_counter_, prac_, max_prac_val_, drfm_sampler_,
+       drfm_issued_, moat_max_prac_idx_, mint_acts_, mint_row_, rng_,
+       graphene_tracker_, hydra_gct_, hydra_gct_valid_, hydra_counts_);
 }
 
 void BankState::hydra_preact(const Command& cmd)
@@ -631,10 +586,7 @@ void BankState::hydra_preact(const Command& cmd)
     }
     else
     {
-        hydra_counts_[rowid]++;
-        uint64_t rcc_tag = config_.ResetColBits(cmd.hex_addr);
-        uint64_t rcc_set = config_.RemoveColBits(cmd.hex_addr);
-        const_cast<LRUCache*>(&config_.hydra_rcc)->write(rcc_tag, rcc_set);
+        hydra_counts_.Increment(rowid);
     }
 
     if (hydra_gct_[gct_idx] >= config_.hydra_gct_th and hydra_gct_valid_[gct_idx])
@@ -643,7 +595,7 @@ void BankState::hydra_preact(const Command& cmd)
         hydra_gct_valid_[gct_idx] = false;
         for (int i = 0; i < num_rows_per_gct_; i++)
         {
-            hydra_counts_[i * config_.hydra_gct_size  + gct_idx] = config_.hydra_gct_th;
+            hydra_counts_.Set(i * config_.hydra_gct_size  + gct_idx, config_.hydra_gct_th);
         }
     }
 
@@ -652,11 +604,11 @@ void BankState::hydra_preact(const Command& cmd)
         return;
     }
 
-    if (hydra_counts_[rowid] >= config_.hydra_th)
+    if (hydra_counts_.Get(rowid) >= config_.hydra_th)
     {
         simple_stats_.Increment(hydra_aggressor_stat_);
-        assert(drfm_q_.size() <= config_.drfm_qsize);
-        drfm_q_.emplace_back(rowid, 0);
+        assert(drfm_sampler_.Size() <= config_.drfm_qsize);
+        drfm_sampler_.Insert(rowid);
     }
 }
 
@@ -676,8 +628,7 @@ void BankState::graphene_refresh()
 
     if (ref_idx_ % config_.rows == 0)
     {
-        graphene_q_.clear();
-        graphene_spill_counter_ = 0;
+        graphene_tracker_.Clear();
         simple_stats_.Increment(graphene_resets_stat_);
     }
 }
@@ -694,8 +645,7 @@ void BankState::hydra_refresh()
         hydra_gct_valid_.clear();
         hydra_gct_valid_.resize(config_.hydra_gct_size, true);
 
-        hydra_counts_.clear();
-        hydra_counts_.resize(config_.rows, 0);
+        hydra_counts_.Clear();
 
         simple_stats_.Increment(hydra_resets_stat_);
     }
@@ -729,14 +679,11 @@ void BankState::graphene_mitig()
 
     int64_t rowid = drfm_mitig();
 
-    auto max_entry = std::max_element(graphene_q_.begin(), graphene_q_.end(), [] (const GRAPHENE_Q_Entry& a, const GRAPHENE_Q_Entry& b) {
-        return a.ctr < b.ctr;
-    });
+    int64_t max_rowid = graphene_tracker_.PopMax();
 
-    if (max_entry != graphene_q_.end())
+    if (max_rowid != -1)
     {
-        assert(rowid != -1 and rowid == max_entry->rowid);
-        graphene_q_.erase(max_entry);
+        assert(rowid != -1 and rowid == max_rowid);
     }
 }
 
@@ -748,7 +695,7 @@ void BankState::hydra_mitig()
 
     if (rowid != -1)
     {
-        hydra_counts_[rowid] = 0;
+        hydra_counts_.Set(rowid, 0);
     }
 }
 
@@ -761,19 +708,13 @@ void BankState::abacus_mitig()
 
 int64_t BankState::drfm_mitig()
 {
-    // Find max drfm q entry, if all the values same give me the first one
-    auto max_entry = std::max_element(drfm_q_.begin(), drfm_q_.end(), [] (const DRFM_Q_Entry& a, const DRFM_Q_Entry& b) {
-        return a.ctr < b.ctr;
-    });
+    // Take the max drfm q entry, if all the values same give me the first one
+    int64_t rowid = drfm_sampler_.PopMax();
 
-    if (max_entry != drfm_q_.end()) 
+    if (rowid != -1)
     {
-        if (max_entry->ctr <= drfm_q_[0].ctr)
-            max_entry = drfm_q_.begin();
-    
         simple_stats_.Increment(mitig_used_stat_);
-        drfm_q_.erase(max_entry);
-        return max_entry->rowid;
+        return rowid;
     }
     else
     {
@@ -793,7 +734,7 @@ void BankState::moat_act(uint32_t rowid)
     {
         moat_max_prac_idx_ = rowid;
     }
-    else if (prac_[rowid] > prac_[moat_max_prac_idx_])
+    else if (prac_.Get(rowid) > prac_.Get(moat_max_prac_idx_))
     {
         moat_max_prac_idx_ = rowid;
     }
@@ -819,12 +760,12 @@ void BankState::moat_mitig()
         return;
     }
 
-    prac_[moat_max_prac_idx_] = 0;
+    prac_.Set(moat_max_prac_idx_, 0);
     
-    if (moat_max_prac_idx_ > 0) prac_[moat_max_prac_idx_ - 1]++;
-    if (moat_max_prac_idx_ > 1) prac_[moat_max_prac_idx_ - 2]++;
-    if (moat_max_prac_idx_ < config_.rows - 1) prac_[moat_max_prac_idx_ + 1]++;
-    if (moat_max_prac_idx_ < config_.rows - 2) prac_[moat_max_prac_idx_ + 2]++;
+    if (moat_max_prac_idx_ > 0) prac_.Increment(moat_max_prac_idx_ - 1);
+    if (moat_max_prac_idx_ > 1) prac_.Increment(moat_max_prac_idx_ - 2);
+    if (moat_max_prac_idx_ < config_.rows - 1) prac_.Increment(moat_max_prac_idx_ + 1);
+    if (moat_max_prac_idx_ < config_.rows - 2) prac_.Increment(moat_max_prac_idx_ + 2);
 
     moat_max_prac_idx_ = -1;
 }
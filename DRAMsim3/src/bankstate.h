@@ -1,46 +1,88 @@
 #ifndef __BANKSTATE_H
 #define __BANKSTATE_H
 
+#include <algorithm>
+#include <limits>
 #include <vector>
 #include "common.h"
 #include "configuration.h"
+#include "drfm_sampler.h"
+#include "graphene_tracker.h"
+#include "rng.h"
+#include "row_counters.h"
 #include "simple_stats.h"
+#include "state_io.h"
 
 namespace dramsim3 {
 
-struct DRFM_Q_Entry {
-    uint32_t rowid;
-    uint16_t ctr;
+// Earliest time each command can be issued to each bank of a channel, stored
+// as one contiguous array per command type indexed by flat bank id
+// (rank * banks + bankgroup * banks_per_group + bank), so that rank, bankgroup
+// and "other ranks" updates are a plain max over a contiguous span
+class BankTiming {
+   public:
+    explicit BankTiming(int num_banks)
+        : num_banks_(num_banks),
+          timing_(static_cast<int>(CommandType::SIZE) * num_banks, 0) {}
 
-    DRFM_Q_Entry(uint32_t r, uint16_t c) : rowid(r), ctr(c) {}
+    uint64_t Get(CommandType cmd_type, int bank_id) const {
+        return timing_[static_cast<int>(cmd_type) * num_banks_ + bank_id];
+    }
 
-    std::string to_string() const
-    {
-        return "RowID: " + std::to_string(rowid) + " Ctr: " + std::to_string(ctr);
+    void Update(CommandType cmd_type, int bank_id, uint64_t time) {
+        uint64_t& t = timing_[static_cast<int>(cmd_type) * num_banks_ + bank_id];
+        t = std::max(t, time);
+    }
+
+    // banks [first, last)
+    void UpdateSpan(CommandType cmd_type, int first, int last, uint64_t time) {
+        uint64_t* t = timing_.data() + static_cast<int>(cmd_type) * num_banks_;
+        for (int i = first; i < last; i++) {
+            t[i] = t[i] < time ? time : t[i];
+        }
+    }
+
+    // count banks starting at first, stride apart
+    void UpdateStrided(CommandType cmd_type, int first, int stride, int count,
+                       uint64_t time) {
+        uint64_t* t = timing_.data() + static_cast<int>(cmd_type) * num_banks_;
+        for (int i = 0; i < count; i++) {
+            uint64_t& v = t[first + i * stride];
+            v = v < time ? time : v;
+        }
     }
-};
 
-// [GRAPHENE]
-struct GRAPHENE_Q_Entry {
-    uint32_t rowid;
-    uint16_t ctr;
+    void Checkpoint(StateIO& io) { io(timing_); }
 
-    GRAPHENE_Q_Entry(uint32_t r, uint16_t c) : rowid(r), ctr(c) {}
+   private:
+    int num_banks_;
+    std::vector<uint64_t> timing_;
 };
 
 class BankState {
    public:
-    BankState(const Config& config, SimpleStats& simple_stats, int rank, int bank_group, int bank);
+    BankState(const Config& config, SimpleStats& simple_stats,
+              const BankTiming& bank_timing, int channel, int rank, int bank_group, int bank);
 
     enum class State { OPEN, CLOSED, SREF, PD, SIZE };
     Command GetReadyCommand(const Command& cmd, uint64_t clk) const;
 
+    // command that has to go to this bank first in order to serve cmd
+    // (SIZE if none can be issued)
+    CommandType RequiredCommand(const Command& cmd) const;
+
+    // earliest cycle GetReadyCommand(cmd, clk) can return a command, timings
+    // never move backwards so this holds until UpdateState() is called
+    uint64_t EarliestReadyCycle(const Command& cmd) const {
+        CommandType required_type = RequiredCommand(cmd);
+        return required_type == CommandType::SIZE
+                   ? std::numeric_limits<uint64_t>::max()
+                   : bank_timing_->Get(required_type, bank_id_);
+    }
+
     // Update the state of the bank resulting after the execution of the command
     void UpdateState(const Command& cmd, uint64_t clk);
 
-    // Update the existing timing constraints for the command
-    void UpdateTiming(const CommandType cmd_type, uint64_t time);
-
     bool IsRowOpen() const { return state_ == State::OPEN; }
     int OpenRow() const { return open_row_; }
     int RowHitCount() const { return row_hit_count_; }
@@ -61,8 +103,12 @@ class BankState {
     bool IsInDRFM() const;
 
     void insert_drfm(uint32_t rowid);
+    void insert_drfm(const uint32_t* rowids, int num);
+
+    // [HYDRA] whether an ACT to rowid goes through the channel's RCC
+    bool hydra_uses_rcc(uint32_t rowid) const;
 
-    int64_t hydra_check_rcc(const Command& cmd);
+    void Checkpoint(StateIO& io);
    private:
     const Config& config_;
     SimpleStats& simple_stats_;
@@ -71,8 +117,10 @@ class BankState {
     // Apriori or instantaneously transitions on a command.
     State state_;
 
-    // Earliest time when the particular Command can be executed in this bank
-    std::vector<uint64_t> cmd_timing_;
+    // Earliest time when the particular Command can be executed in this bank,
+    // owned by the ChannelState
+    const BankTiming* bank_timing_;
+    int bank_id_;
 
     Command last_cmd_;
 
@@ -91,7 +139,7 @@ class BankState {
     int raa_ctr_;
 
     // Activations
-    std::string acts_stat_name_;
+    int acts_stat_;
     std::string bank_identifier;
     int acts_counter_;
 
@@ -100,17 +148,18 @@ class BankState {
     uint32_t fgr_counter_;
 
     // [PRAC] Counters
-    std::vector<uint32_t> prac_;
+    RowCounters prac_;
+    int acts_per_row_stat_;
     uint32_t max_prac_val_;
 
     // [DRFM]
-    std::vector<DRFM_Q_Entry> drfm_q_;
+    DRFMSampler drfm_sampler_;
     bool drfm_issued_;
     void drfm_post_act(uint32_t rowid);
     int64_t drfm_mitig();
     
-    std::string mitig_used_stat_;
-    std::string mitig_wasted_stat_;
+    int mitig_used_stat_;
+    int mitig_wasted_stat_;
 
     // [ABACUS]
     void abacus_mitig();
@@ -128,33 +177,36 @@ class BankState {
     void mint_preact(uint32_t rowid);
     void mint_refresh();
     void mint_mitig();
-    std::vector<uint32_t> mint_rows_;
+    // reservoir of one over the ACTs of the current window
+    int mint_acts_;
+    uint32_t mint_row_;
 
     // [PARA]
     void para_preact(uint32_t rowid);
     void para_refresh();
     void para_mitig();
 
+    // [MINT] [PARA] seeded per bank, see Config::seed
+    Rng rng_;
+
     // [GRAPHENE]
     void graphene_preact(uint32_t rowid);
     void graphene_refresh();
     void graphene_mitig();
-    std::vector<GRAPHENE_Q_Entry> graphene_q_;
-    uint64_t graphene_spill_counter_;
-    uint32_t graphene_entries_;
-    std::string graphene_spills_stat_;
-    std::string graphene_resets_stat_;
+    GrapheneTracker graphene_tracker_;
+    int graphene_spills_stat_;
+    int graphene_resets_stat_;
 
     // [Hydra]
     void hydra_preact(const Command& cmd);
     void hydra_refresh();
     void hydra_mitig();
-    std::string hydra_resets_stat_;
-    std::string hydra_gct_overflows_stat_;
-    std::string hydra_aggressor_stat_;
+    int hydra_resets_stat_;
+    int hydra_gct_overflows_stat_;
+    int hydra_aggressor_stat_;
     std::vector<uint32_t> hydra_gct_;
     std::vector<bool> hydra_gct_valid_;
-    std::vector<uint32_t> hydra_counts_;
+    RowCounters hydra_counts_;
     uint32_t num_rows_per_gct_;
 
 };
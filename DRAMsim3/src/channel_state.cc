@@ -8,9 +8,14 @@ ChannelState::ChannelState(const Config& config, const Timing& timing, SimpleSta
       timing_(timing),
       simple_stats_(simple_stats),
       channel_(channel),
+      num_alerts_stat_(simple_stats.GetStatId("num_alerts")),
+      bursty_access_count_stat_(
+          simple_stats.GetHistoStatId("bursty_access_count")),
       rank_is_sref_(config.ranks, false),
-      four_aw_(config_.ranks, std::vector<uint64_t>()),
-      thirty_two_aw_(config_.ranks, std::vector<uint64_t>()) {
+      bank_timing_(config.ranks * config.banks),
+      hydra_rcc_(simple_stats),
+      four_aw_(config_.ranks, RollingWindow(4, config_.tFAW)),
+      thirty_two_aw_(config_.ranks, RollingWindow(32, config_.t32AW)) {
     
     bank_states_.reserve(config_.ranks);
 
@@ -23,15 +28,26 @@ ChannelState::ChannelState(const Config& config, const Timing& timing, SimpleSta
             std::vector<BankState> bg_states;
             for (auto k = 0; k < config_.banks_per_group; k++)
             {
-                bg_states.push_back(BankState(config_, simple_stats_, i, j, k));
+                bg_states.push_back(BankState(config_, simple_stats_, bank_timing_, channel_, i, j, k));
             }
             rank_states.push_back(bg_states);
         }
         bank_states_.push_back(rank_states);
     }
 
+    if (config_.ranks > 1) {
+        InitUpdateTimingFns<true>();
+    } else {
+        InitUpdateTimingFns<false>();
+    }
+
     // [Hydra]
     hydra_wb_draining_ = false;
+    if (config_.hydra_mode != 0)
+    {
+        hydra_waits_.resize(config_.ranks * config_.banks);
+        hydra_rcc_.Init(config_.hydra_rcc_sets, config_.hydra_rcc_ways);
+    }
 
     // [ABO]
     alert_n = false;
@@ -42,6 +58,8 @@ ChannelState::ChannelState(const Config& config, const Timing& timing, SimpleSta
     ref_idx_ = 0;
     fgr_counter_ = 0;
 
+    defer_output_ = false;
+
     // [Tracking]
     last_bus_access_time_ = 0;
     bursty_access_count_ = 0;
@@ -50,15 +68,51 @@ ChannelState::ChannelState(const Config& config, const Timing& timing, SimpleSta
     tusc_.resize(config_.rows / config_.dream_k, 0);
     tusc_prev_.resize(config_.rows / config_.dream_k, 0);
     tusc_size_ = tusc_.size();
+    // the channel's generator takes the stream after the ones of all banks
+    Rng rng(config_.seed, static_cast<uint64_t>(config_.channels + channel_) * config_.ranks * config_.banks);
     for (uint32_t i = 0; i < config_.ranks * config_.bankgroups * config_.banks_per_group * config_.dream_k; i++)
     {
-        random_masks.push_back(rand() % tusc_size_);
+        random_masks.push_back(rng.Below(tusc_size_));
+    }
+
+    // rows sharing entry tusc_idx, per (bank, row_num):
+    //   Set-Associative: tusc_idx * dream_k + row_num
+    //   Staggered:       (tusc_idx + bank_idx + row_num * tusc_size_) % rows
+    //   Random:          (tusc_idx ^ random_mask) * dream_k + row_num
+    // kept as xor/add terms, see dream_fanout()
+    uint32_t total_banks = config_.ranks * config_.bankgroups * config_.banks_per_group;
+    for (uint32_t bank_idx = 0; bank_idx < total_banks; bank_idx++)
+    {
+        for (uint32_t row_num = 0; row_num < (uint32_t)config_.dream_k; row_num++)
+        {
+            switch (config_.dream_policy)
+            {
+                case 0: // Set-Associative
+                    dream_fanout_xor_.push_back(0);
+                    dream_fanout_add_.push_back(row_num);
+                    break;
+                case 1: // Staggered
+                    dream_fanout_xor_.push_back(0);
+                    dream_fanout_add_.push_back(bank_idx + row_num * tusc_size_);
+                    break;
+                case 2: // Random
+                    dream_fanout_xor_.push_back(random_masks[bank_idx + row_num * total_banks]);
+                    dream_fanout_add_.push_back(row_num);
+                    break;
+                default:
+                    std::cerr << "[DREAM] unknown dream_policy " << config_.dream_policy << std::endl;
+                    AbruptExit(__FILE__, __LINE__);
+            }
+        }
     }
+    dream_fanout_rows_.resize(dream_fanout_add_.size());
+
+    tusc_count_hist_.assign(1, tusc_size_);
+    tusc_sum_ = 0;
 
     if (config_.dream_mode == 1)
     {
-        dream_resets_stat_ = "dream_resets";
-        simple_stats_.InitStat(dream_resets_stat_, "counter", "dream Resets Counter");
+        dream_resets_stat_ = simple_stats_.InitCounter("dream_resets", "dream Resets Counter");
     }
     else if (config_.abacus_mode == 1)
     {
@@ -66,9 +120,39 @@ ChannelState::ChannelState(const Config& config, const Timing& timing, SimpleSta
         abacus_entries_ = config_.rows;
         std::cout << "ABACUS Entries: " << abacus_entries_ << std::endl;
         abacus_table_.resize(abacus_entries_);
-        
-        abacus_resets_stat_ = "abacus_resets";
-        simple_stats_.InitStat(abacus_resets_stat_, "counter", "abacus Resets Counter");
+
+        // one SAV bit per bank of the channel
+        int total_banks = config_.ranks * config_.banks;
+        if (total_banks <= 64)
+        {
+            abacus_sav_words_ = 1;
+            abacus_preact_fn_ = &ChannelState::AbacusPreactKernel<1>;
+        }
+        else if (total_banks <= 128)
+        {
+            abacus_sav_words_ = 2;
+            abacus_preact_fn_ = &ChannelState::AbacusPreactKernel<2>;
+        }
+        else if (total_banks <= 256)
+        {
+            abacus_sav_words_ = 4;
+            abacus_preact_fn_ = &ChannelState::AbacusPreactKernel<4>;
+        }
+        else if (total_banks <= 512)
+        {
+            abacus_sav_words_ = 8;
+            abacus_preact_fn_ = &ChannelState::AbacusPreactKernel<8>;
+        }
+        else
+        {
+            std::cerr << "[ABACUS] at most 512 banks per channel, got " << total_banks << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+        abacus_sav_.resize(static_cast<size_t>(abacus_entries_) * abacus_sav_words_, 0);
+        abacus_rows_per_ref_ = abacus_entries_ / config_.refchunks;
+        abacus_chunk_epoch_.resize(config_.refchunks + 1, 0);
+
+        abacus_resets_stat_ = simple_stats_.InitCounter("abacus_resets", "abacus Resets Counter");
     }
 }
 
@@ -99,29 +183,31 @@ uint32_t ChannelState::get_tusc_idx(uint32_t rank, uint32_t bankgroup, uint32_t
     AbruptExit(__FILE__, __LINE__);
 }
 
-uint32_t ChannelState::get_row_idx(uint32_t rank, uint32_t bankgroup, uint32_t bank, uint32_t tusc_idx, uint32_t row_num) const 
+void ChannelState::dream_fanout(uint32_t tusc_idx)
 {
-    uint32_t bank_idx = rank * config_.bankgroups * config_.banks_per_group + bankgroup * config_.banks_per_group + bank;
-    uint32_t total_banks = config_.ranks * config_.bankgroups * config_.banks_per_group;
+    // rows of tusc_idx for every (bank, row_num) at once, one branch free pass
+    // over the terms precomputed in the constructor
+    const uint32_t* xor_terms = dream_fanout_xor_.data();
+    const uint32_t* add_terms = dream_fanout_add_.data();
+    uint32_t* rows = dream_fanout_rows_.data();
+    size_t num = dream_fanout_rows_.size();
 
-    if (config_.dream_policy == 0) // Set-Associative
-    {
-        return tusc_idx * config_.dream_k + row_num;
-    }
-    
     if (config_.dream_policy == 1) // Staggered
     {
-        uint32_t rowid = (tusc_idx + bank_idx + row_num * tusc_size_) % config_.rows;
-        return rowid;
+        uint32_t num_rows = config_.rows;
+        for (size_t i = 0; i < num; i++)
+        {
+            rows[i] = (tusc_idx + add_terms[i]) % num_rows;
+        }
     }
-    
-    if (config_.dream_policy == 2) // Random
+    else // Set-Associative, Random
     {
-        uint32_t rowid = (tusc_idx ^ random_masks[bank_idx + row_num * total_banks]) * config_.dream_k + row_num;
-        return rowid;
+        uint32_t dream_k = config_.dream_k;
+        for (size_t i = 0; i < num; i++)
+        {
+            rows[i] = (tusc_idx ^ xor_terms[i]) * dream_k + add_terms[i];
+        }
     }
-    
-    AbruptExit(__FILE__, __LINE__);
 }
 
 void ChannelState::dream_preact(uint32_t rank, uint32_t bankgroup, uint32_t bank, uint32_t rowid) 
@@ -129,7 +215,19 @@ void ChannelState::dream_preact(uint32_t rank, uint32_t bankgroup, uint32_t bank
     uint32_t tusc_idx = get_tusc_idx(rank, bankgroup, bank, rowid);
     tusc_[tusc_idx]++;
 
-    if (config_.dream_mode == 0) return;
+    if (config_.dream_mode == 0)
+    {
+        // telemetry, move the entry to its new count
+        uint32_t val = tusc_[tusc_idx];
+        if (val >= tusc_count_hist_.size())
+        {
+            tusc_count_hist_.resize(std::max<size_t>(val + 1, tusc_count_hist_.size() * 2), 0);
+        }
+        tusc_count_hist_[val - 1]--;
+        tusc_count_hist_[val]++;
+        tusc_sum_++;
+        return;
+    }
 
     uint32_t counter_val = tusc_[tusc_idx];
     uint32_t threshold = config_.dream_th;
@@ -143,47 +241,65 @@ void ChannelState::dream_preact(uint32_t rank, uint32_t bankgroup, uint32_t bank
     if (counter_val >= threshold)
     {
         // insert DRFM entry to all the banks
+        dream_fanout(tusc_idx);
+        const uint32_t* rows = dream_fanout_rows_.data();
         for (int i = 0; i < config_.ranks; i++)
         {
             for (int j = 0; j < config_.bankgroups; j++)
             {
                 for (int k = 0; k < config_.banks_per_group; k++)
                 {
-                    for (int l = 0; l < config_.dream_k; l++)
-                    {
-                        uint32_t _rowid = get_row_idx(i, j, k, tusc_idx, l);
-                        bank_states_[i][j][k].insert_drfm(_rowid);
-                    }
+                    bank_states_[i][j][k].insert_drfm(rows, config_.dream_k);
+                    rows += config_.dream_k;
                 }
             }
         }
 
         // push the same tusc_idx to the queue
-        for (int l = 0; l < config_.dream_k; l++)
-        {
-            tusc_q_.push_back(tusc_idx);
-        }
+        tusc_q_.push_back(tusc_idx, config_.dream_k);
     }
 }
 
-void ChannelState::abacus_preact(uint32_t rank, uint32_t bankgroup, uint32_t bank, uint32_t rowid) 
+template <int kWords>
+bool ChannelState::AbacusPreactKernel(uint32_t bank_idx, uint32_t rowid)
 {
-    if (config_.abacus_mode == 0) return;
-
-    uint32_t bank_idx = rank * config_.bankgroups * config_.banks_per_group + bankgroup * config_.banks_per_group + bank;
-    uint64_t bank_mask = 0x1ull << bank_idx;
+    ABACUS_Entry& entry = abacus_table_[rowid];
+    uint64_t* sav = &abacus_sav_[static_cast<size_t>(rowid) * kWords];
+
+    // rows past the last full chunk are never reset by a refresh
+    uint32_t chunk = abacus_rows_per_ref_ == 0 ? config_.refchunks
+                   : std::min<uint32_t>(rowid / abacus_rows_per_ref_, config_.refchunks);
+    uint32_t epoch = abacus_chunk_epoch_[chunk];
+    if (entry.epoch != epoch)
+    {
+        entry.epoch = epoch;
+        entry.rac = 0;
+        std::fill(sav, sav + kWords, 0);
+    }
 
-    if ((abacus_table_[rowid].sav & bank_mask) == 0)
+    uint64_t bank_mask = 0x1ull << (bank_idx % 64);
+    uint64_t& word = sav[bank_idx / 64];
+    if ((word & bank_mask) == 0)
     {
-        abacus_table_[rowid].sav |= bank_mask;
+        word |= bank_mask;
     }
     else
     {
-        abacus_table_[rowid].rac++;
-        abacus_table_[rowid].sav = bank_mask;
+        entry.rac++;
+        std::fill(sav, sav + kWords, 0);
+        word = bank_mask;
     }
 
-    if (abacus_table_[rowid].rac >= config_.abacus_th)
+    return static_cast<int>(entry.rac) >= config_.abacus_th;
+}
+
+void ChannelState::abacus_preact(uint32_t rank, uint32_t bankgroup, uint32_t bank, uint32_t rowid) 
+{
+    if (config_.abacus_mode == 0) return;
+
+    uint32_t bank_idx = rank * config_.bankgroups * config_.banks_per_group + bankgroup * config_.banks_per_group + bank;
+
+    if ((this->*abacus_preact_fn_)(bank_idx, rowid))
     {
         // insert DRFM entry to all the banks
         for (int i = 0; i < config_.ranks; i++)
@@ -211,7 +327,7 @@ void ChannelState::dream_mitig()
     uint32_t tusc_idx = tusc_q_.front();
     tusc_prev_[tusc_idx] = tusc_[tusc_idx];
     tusc_[tusc_idx] = 0;
-    tusc_q_.erase(tusc_q_.begin());
+    tusc_q_.pop_front();
 }
 
 void ChannelState::abacus_mitig() 
@@ -222,8 +338,8 @@ void ChannelState::abacus_mitig()
 
     uint32_t rowid = abacus_q_.front();
     abacus_table_[rowid].rac = 0;
-    abacus_table_[rowid].sav = 0;
-    abacus_q_.erase(abacus_q_.begin());
+    std::fill_n(&abacus_sav_[static_cast<size_t>(rowid) * abacus_sav_words_], abacus_sav_words_, 0);
+    abacus_q_.pop_front();
 }
 
 void ChannelState::dream_refresh()
@@ -233,28 +349,53 @@ void ChannelState::dream_refresh()
     // Just to dump stats
     if (config_.dream_mode == 0 and ref_idx_ % (config_.refchunks / factor) == 0 and fgr_counter_ == 0)
     {
-        // Get quantiles from tusc_
-        std::sort(tusc_.begin(), tusc_.end());
-        uint32_t min = tusc_[0];
-        uint32_t q25 = tusc_[tusc_size_ / 4];
-        uint32_t q50 = tusc_[tusc_size_ / 2];
-        uint32_t q75 = tusc_[tusc_size_ * 3 / 4];
-        uint32_t q90 = tusc_[tusc_size_ * 9 / 10];
-        uint32_t q99 = tusc_[tusc_size_ * 99 / 100];
-        uint32_t max = tusc_[tusc_size_ - 1];
-
-        double sum = std::accumulate(tusc_.begin(), tusc_.end(), 0.0);
-        double mean = sum / tusc_.size();
-        std::vector<double> diff(tusc_.size());
-        std::transform(tusc_.begin(), tusc_.end(), diff.begin(), [mean](double x) { return x - mean; });
-        double sq_sum = std::inner_product(diff.begin(), diff.end(), diff.begin(), 0.0);
-        double stdev = std::sqrt(sq_sum / tusc_.size());
-
-        fmt::print("\n[{}][{}] mean: {} stddev: {} min: {} q25: {} q50: {} q75: {} q90: {} q99: {} max: {}\n", 
+        // Get quantiles from the count histogram, the ranks below are the
+        // indices the quantiles would have in the sorted tusc_
+        const uint64_t ranks[] = {0, tusc_size_ / 4, tusc_size_ / 2, tusc_size_ * 3 / 4,
+                                  tusc_size_ * 9 / 10, tusc_size_ * 99 / 100, tusc_size_ - 1};
+        const int num_ranks = sizeof(ranks) / sizeof(ranks[0]);
+        uint32_t quantiles[num_ranks];
+        double mean = static_cast<double>(tusc_sum_) / tusc_size_;
+        // sum of squares in integers, the variance is then
+        // (n * sum(v^2) - sum(v)^2) / n^2 without any rounding until the end
+        unsigned __int128 sq_sum = 0;
+        uint64_t seen = 0;
+        for (uint32_t val = 0, r = 0; val < tusc_count_hist_.size(); val++)
+        {
+            uint64_t count = tusc_count_hist_[val];
+            if (count == 0) continue;
+            seen += count;
+            while (r < num_ranks and ranks[r] < seen)
+            {
+                quantiles[r++] = val;
+            }
+            sq_sum += static_cast<unsigned __int128>(count) * val * val;
+        }
+        uint32_t min = quantiles[0];
+        uint32_t q25 = quantiles[1];
+        uint32_t q50 = quantiles[2];
+        uint32_t q75 = quantiles[3];
+        uint32_t q90 = quantiles[4];
+        uint32_t q99 = quantiles[5];
+        uint32_t max = quantiles[6];
+        unsigned __int128 n = tusc_size_;
+        unsigned __int128 sum = tusc_sum_;
+        double variance = static_cast<double>(n * sq_sum - sum * sum) /
+                          (static_cast<double>(n) * n);
+        double stdev = std::sqrt(variance);
+
+        auto line = fmt::format("\n[{}][{}] mean: {} stddev: {} min: {} q25: {} q50: {} q75: {} q90: {} q99: {} max: {}\n", 
             channel_, ref_idx_, mean, stdev, min, q25, q50, q75, q90, q99, max);
+        if (defer_output_) {
+            deferred_output_ += line;
+        } else {
+            fmt::print("{}", line);
+        }
 
-        tusc_.clear();
-        tusc_.resize(tusc_size_, 0);
+        std::fill(tusc_.begin(), tusc_.end(), 0);
+        std::fill(tusc_count_hist_.begin(), tusc_count_hist_.end(), 0);
+        tusc_count_hist_[0] = tusc_size_;
+        tusc_sum_ = 0;
     }
     else if (config_.dream_mode == 1 and fgr_counter_ == 7)
     {
@@ -277,14 +418,11 @@ void ChannelState::abacus_refresh()
 
     if (fgr_counter_ == 7)
     {
+        // resets the rows [start, start + 1) * abacus_rows_per_ref_
         uint32_t start = ref_idx_ % config_.refchunks;
-        uint32_t abacus_rows_per_ref = abacus_entries_ / config_.refchunks;
-
-        for (int i = 0; i < abacus_rows_per_ref; i++)
+        if (abacus_rows_per_ref_ > 0)
         {
-            uint32_t rowid = start * abacus_rows_per_ref + i;
-            abacus_table_[rowid].rac = 0;
-            abacus_table_[rowid].sav = 0;
+            abacus_chunk_epoch_[start]++;
         }
 
         simple_stats_.Increment(abacus_resets_stat_);
@@ -293,6 +431,31 @@ void ChannelState::abacus_refresh()
 
 
 
+void ChannelState::Checkpoint(StateIO& io) {
+    io(rank_idle_cycles, deferred_output_, last_bus_access_time_,
+       bursty_access_count_, rank_is_sref_, bank_timing_);
+    // BankState has no default constructor, the banks are there already
+    for (auto& rank_states : bank_states_) {
+        for (auto& bg_states : rank_states) {
+            for (auto& bank_state : bg_states) {
+                io(bank_state);
+            }
+        }
+    }
+    io(refresh_q_, rfm_q_, hydra_rd_q_, hydra_wb_q_, hydra_wb_draining_,
+       hydra_waits_, hydra_rcc_, ref_idx_, fgr_counter_, four_aw_,
+       thirty_two_aw_, tusc_, tusc_prev_, tusc_count_hist_, tusc_sum_,
+       tusc_q_, abacus_table_, abacus_sav_, abacus_chunk_epoch_, abacus_q_,
+       alert_n, last_alert_clk_, num_acts_abo_);
+}
+
+void ChannelState::FlushOutput() {
+    if (!deferred_output_.empty()) {
+        fmt::print("{}", deferred_output_);
+        deferred_output_.clear();
+    }
+}
+
 void ChannelState::PrintDeadlock() const {
     for (auto i = 0; i < config_.ranks; i++) {
         for (auto j = 0; j < config_.bankgroups; j++) {
@@ -326,7 +489,7 @@ bool ChannelState::IsRWPendingOnRef(const Command& cmd) const {
             bank_states_[rank][bankgroup][bank].OpenRow() == cmd.Row());
 }
 
-bool ChannelState::HydraRead(int rank, int bankgroup, int bank, int row) {
+bool ChannelState::HydraRead(int waiter, int rank, int bankgroup, int bank, int row) {
     // if (channel_ == 0)
     // printf("HydraRead: channel %d rank %d bankgroup %d bank %d row %d\n", channel_, rank, bankgroup, bank, row);
     // check if request is already present in the writeback queue
@@ -346,15 +509,28 @@ bool ChannelState::HydraRead(int rank, int bankgroup, int bank, int row) {
     }
 
     // check if request is already present in the read queue
+    HydraFetch* fetch = nullptr;
     for (auto it = hydra_rd_q_.begin(); it != hydra_rd_q_.end(); it++) {
-        if (it->Rank() == rank && it->Bankgroup() == bankgroup &&
-            it->Bank() == bank && it->Row() == row) {
-            return false;
+        if (it->cmd.Rank() == rank && it->cmd.Bankgroup() == bankgroup &&
+            it->cmd.Bank() == bank && it->cmd.Row() == row) {
+            fetch = &(*it);
+            break;
         }
     }
 
-    Address addr = Address(channel_, rank, bankgroup, bank, row, -1);
-    hydra_rd_q_.emplace_back(CommandType::READ, addr, -1);
+    if (fetch == nullptr)
+    {
+        Address addr = Address(channel_, rank, bankgroup, bank, row, -1);
+        hydra_rd_q_.push_back(HydraFetch{Command(CommandType::READ, addr, -1), {}});
+        fetch = &hydra_rd_q_.back();
+    }
+
+    // the waiting bank holds off its ACTs until the counter arrives
+    if (std::find(fetch->waiters.begin(), fetch->waiters.end(), waiter) == fetch->waiters.end())
+    {
+        fetch->waiters.push_back(waiter);
+        hydra_waits_[waiter].fetches++;
+    }
     return false;
 }
 
@@ -572,57 +748,80 @@ void ChannelState::RankNeedDRFM(int rank, bool need) {
 
 Command ChannelState::GetReadyHydraCommand(uint64_t clk) const
 {
-    if (hydra_wb_q_.size() >= config_.hydra_wbq_size and !hydra_wb_draining_ and hydra_rd_q_.empty())
-    {
-        const_cast<ChannelState*>(this)->hydra_wb_draining_ = true;
-        // if (channel_ == 0)
-            // std::cout << "GetReadyHydraCommand: Draining WBQ" << std::endl;
-    }
+    ChannelState* self = const_cast<ChannelState*>(this);
 
-    if (hydra_wb_q_.empty())
+    // write-backs drain once the queue reaches its high watermark and until
+    // it is back down to the low one
+    if (hydra_wb_q_.size() >= static_cast<size_t>(config_.hydra_wbq_size))
     {
-        const_cast<ChannelState*>(this)->hydra_wb_draining_ = false;
+        self->hydra_wb_draining_ = true;
     }
-    
-    std::vector<Command>& queue = hydra_wb_draining_ ? const_cast<ChannelState*>(this)->hydra_wb_q_ : const_cast<ChannelState*>(this)->hydra_rd_q_;
-
-    if (queue.empty())
+    else if (hydra_wb_q_.size() <= static_cast<size_t>(config_.hydra_wbq_low))
     {
-        return Command();
+        self->hydra_wb_draining_ = false;
     }
 
-    Command cmd = queue.front();
-    Command ready_cmd = bank_states_[cmd.Rank()][cmd.Bankgroup()][cmd.Bank()]
-                        .GetReadyCommand(cmd, clk);
-
-    if (ready_cmd.cmd_type == CommandType::ACTIVATE)
+    // counter reads first, ACTs are waiting on them
+    for (auto it = self->hydra_rd_q_.begin(); it != self->hydra_rd_q_.end(); it++)
     {
-        if (!ActivationWindowOk(ready_cmd.Rank(), clk))
+        const Command& cmd = it->cmd;
+        Command ready_cmd = bank_states_[cmd.Rank()][cmd.Bankgroup()][cmd.Bank()]
+                            .GetReadyCommand(cmd, clk);
+        if (!ready_cmd.IsValid())
         {
-            return Command();
+            continue;
+        }
+        if (ready_cmd.cmd_type == CommandType::ACTIVATE and !ActivationWindowOk(ready_cmd.Rank(), clk))
+        {
+            continue;
+        }
+        if (ready_cmd.IsReadWrite())
+        {
+            for (int waiter : it->waiters)
+            {
+                HydraWait& wait = self->hydra_waits_[waiter];
+                wait.fetches--;
+                wait.ready_clk = std::max(wait.ready_clk, clk + config_.read_delay);
+            }
+            self->hydra_rd_q_.erase(it);
         }
+        return ready_cmd;
     }
 
-    if (ready_cmd.IsValid() and ready_cmd.IsReadWrite())
+    if (hydra_wb_draining_)
     {
-        // if (channel_ == 0)
-        // {
-
-        //     std::cout << "before.size: hydra_rd_q_: " << hydra_rd_q_.size() << " hydra_wb_q_: " << hydra_wb_q_.size() << std::endl;
-        //     std::cout << "[" << clk << "] GetReadyHydraCommand: Erasing " << ready_cmd << std::endl;
-        // }
-        queue.erase(queue.begin());
-        // if (channel_ == 0)
-        // {
-        //     std::cout << "after.size: hydra_rd_q_: " << hydra_rd_q_.size() << " hydra_wb_q_: " << hydra_wb_q_.size() << std::endl;
-        // }
+        return self->GetReadyHydraWB(clk);
     }
+    return Command();
+}
 
-    // if (ready_cmd.IsValid() and channel_ == 0)
-    // {
-    //     std::cout << "[" << clk << "] GetReadyHydraCommand: " << ready_cmd << std::endl;
-    // }
-    return ready_cmd;
+Command ChannelState::GetIdleHydraCommand(uint64_t clk) const
+{
+    // nothing else can issue this cycle, so a write-back costs no one
+    return const_cast<ChannelState*>(this)->GetReadyHydraWB(clk);
+}
+
+Command ChannelState::GetReadyHydraWB(uint64_t clk)
+{
+    for (auto it = hydra_wb_q_.begin(); it != hydra_wb_q_.end(); it++)
+    {
+        Command ready_cmd = bank_states_[it->Rank()][it->Bankgroup()][it->Bank()]
+                            .GetReadyCommand(*it, clk);
+        if (!ready_cmd.IsValid())
+        {
+            continue;
+        }
+        if (ready_cmd.cmd_type == CommandType::ACTIVATE and !ActivationWindowOk(ready_cmd.Rank(), clk))
+        {
+            continue;
+        }
+        if (ready_cmd.IsReadWrite())
+        {
+            hydra_wb_q_.erase(it);
+        }
+        return ready_cmd;
+    }
+    return Command();
 }
 
 Command ChannelState::GetReadyCommand(const Command& cmd, uint64_t clk) const
@@ -675,10 +874,6 @@ Command ChannelState::GetReadyCommand(const Command& cmd, uint64_t clk) const
             return Command();
         }
     }
-    else if (hydra_wb_draining_ or !hydra_rd_q_.empty())
-    {
-        return Command();
-    }
     else
     {
         ready_cmd = bank_states_[cmd.Rank()][cmd.Bankgroup()][cmd.Bank()]
@@ -742,20 +937,40 @@ Command ChannelState::GetReadyCommand(const Command& cmd, uint64_t clk) const
             {
 
                 // Check HYDRA RCC
+                bool uses_rcc = bank_s.hydra_uses_rcc(cmd.Row());
+                uint64_t rcc_tag = 0;
+                uint64_t rcc_set = 0;
+                if (uses_rcc)
+                {
+                    rcc_tag = config_.ResetColBits(cmd.hex_addr);
+                    rcc_set = config_.RemoveColBits(cmd.hex_addr);
+                }
                 if (config_.hydra_mode == 1)
                 {
-                    int64_t rcc_state = bank_s.hydra_check_rcc(cmd);
+                    // only this bank waits while its counter is fetched
+                    int bank_idx = BankIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank());
+                    HydraWait& wait = const_cast<ChannelState*>(this)->hydra_waits_[bank_idx];
+                    if (wait.fetches > 0 or clk < wait.ready_clk)
+                    {
+                        return Command();
+                    }
+
+                    // the counter was just fetched for this ACT, go ahead
+                    // even if the RCC line has been evicted again since
+                    bool fetched = wait.row == cmd.Row();
+                    wait.row = -1;
+                    int64_t rcc_state = (uses_rcc and !fetched) ? const_cast<ChannelState*>(this)->hydra_rcc_.Read(rcc_tag, rcc_set) : 0;
                     bool is_inflight = true;
                     if (rcc_state == -1)
                     {
-                        is_inflight = const_cast<ChannelState*>(this)->HydraRead(cmd.Rank(), cmd.Bankgroup(), cmd.Bank(), cmd.Row());
+                        is_inflight = const_cast<ChannelState*>(this)->HydraRead(bank_idx, cmd.Rank(), cmd.Bankgroup(), cmd.Bank(), cmd.Row());
                     }
                     else if (rcc_state !=  0)
                     {
                         // std::cout << "HYDRA RCC: " << rcc_state << std::endl;
                         auto addr = config_.AddressMapping(rcc_state);
-                        is_inflight = const_cast<ChannelState*>(this)->HydraRead(cmd.Rank(), cmd.Bankgroup(), cmd.Bank(), cmd.Row());
-                        is_inflight &= const_cast<ChannelState*>(this)->HydraRead(addr.rank, addr.bankgroup, addr.bank, addr.row);
+                        is_inflight = const_cast<ChannelState*>(this)->HydraRead(bank_idx, cmd.Rank(), cmd.Bankgroup(), cmd.Bank(), cmd.Row());
+                        is_inflight &= const_cast<ChannelState*>(this)->HydraRead(bank_idx, addr.rank, addr.bankgroup, addr.bank, addr.row);
                         const_cast<ChannelState*>(this)->HydraWB(addr.rank, addr.bankgroup, addr.bank, addr.row);
                         // std::cout << "====================================" << std::endl;
                     }
@@ -766,11 +981,17 @@ Command ChannelState::GetReadyCommand(const Command& cmd, uint64_t clk) const
 
                     if (!is_inflight)
                     {
+                        wait.row = cmd.Row();
                         return Command();
                     }
                 }
 
                 bool second = bank_s.PreACT(cmd);
+                if (uses_rcc)
+                {
+                    // the ACT bumped the row's counter
+                    const_cast<ChannelState*>(this)->hydra_rcc_.Write(rcc_tag, rcc_set);
+                }
                 const_cast<ChannelState*>(this)->dream_preact(cmd.Rank(), cmd.Bankgroup(), cmd.Bank(), cmd.Row());
                 const_cast<ChannelState*>(this)->abacus_preact(cmd.Rank(), cmd.Bankgroup(), cmd.Bank(), cmd.Row());
 
@@ -898,7 +1119,7 @@ void ChannelState::UpdateState(const Command& cmd, uint64_t clk)
         }
         else
         {
-            simple_stats_.AddValue("bursty_access_count", bursty_access_count_);
+            simple_stats_.AddValue(bursty_access_count_stat_, bursty_access_count_);
             bursty_access_count_ = 0;
         }
         last_bus_access_time_ = clk;
@@ -918,7 +1139,7 @@ void ChannelState::TriggerSameBankAlert(const Command& cmd, uint64_t clk)
     {
         alert_n = true;
         last_alert_clk_ = clk;
-        simple_stats_.Increment("num_alerts");
+        simple_stats_.Increment(num_alerts_stat_);
     }
     return;
 }
@@ -944,113 +1165,176 @@ void ChannelState::TriggerSameRankAlert(const Command& cmd, uint64_t clk)
             {
                 alert_n = true;
                 last_alert_clk_ = clk;
-                simple_stats_.Increment("num_alerts");
+                simple_stats_.Increment(num_alerts_stat_);
             }
         }
     }
     return;
 }
 
-void ChannelState::UpdateTiming(const Command& cmd, uint64_t clk)
-{
-    switch (cmd.cmd_type) {
+namespace {
+
+// commands that update same bank / same bankgroup / same rank / other ranks
+constexpr bool IsBankTimingCmd(CommandType cmd_type) {
+    switch (cmd_type) {
         case CommandType::ACTIVATE:
-            num_acts_abo_++;
-            UpdateActivationTimes(cmd.Rank(), clk);
         case CommandType::READ_PRECHARGE:
         case CommandType::WRITE_PRECHARGE:
         case CommandType::PRECHARGE:
         case CommandType::PREab:
         case CommandType::PREsb:
-            TriggerSameBankAlert(cmd, clk);
         case CommandType::READ:
         case CommandType::WRITE:
         case CommandType::REFRESH_BANK:
         case CommandType::DRFMb:
-            // TODO - simulator speed? - Speciazlize which of the below
-            // functions to call depending on the command type  Same Bank
-            UpdateSameBankTiming(
-                cmd.addr, timing_.same_bank[static_cast<int>(cmd.cmd_type)],
-                clk);
-
-            // Same Bankgroup other banks
-            UpdateOtherBanksSameBankgroupTiming(
-                cmd.addr,
-                timing_
-                    .other_banks_same_bankgroup[static_cast<int>(cmd.cmd_type)],
-                clk);
-
-            // Other bankgroups
-            UpdateOtherBankgroupsSameRankTiming(
-                cmd.addr,
-                timing_
-                    .other_bankgroups_same_rank[static_cast<int>(cmd.cmd_type)],
-                clk);
-
-            // Other ranks
-            UpdateOtherRanksTiming(
-                cmd.addr, timing_.other_ranks[static_cast<int>(cmd.cmd_type)],
-                clk);
-            break;
+            return true;
+        default:
+            return false;
+    }
+}
 
-        case CommandType::RFMab: // [RFM] All Bank RFM
-            num_acts_abo_ = 0;
+constexpr bool IsRankTimingCmd(CommandType cmd_type) {
+    switch (cmd_type) {
+        case CommandType::RFMab:
         case CommandType::REFab:
-            TriggerSameRankAlert(cmd, clk);
         case CommandType::DRFMab:
         case CommandType::SREF_ENTER:
         case CommandType::SREF_EXIT:
-            UpdateSameRankTiming(
-                cmd.addr, timing_.same_rank[static_cast<int>(cmd.cmd_type)],
-                clk);
-            break;
-        case CommandType::REFsb: // [RFM] Same Bank RFM
-        case CommandType::RFMsb: // [RFM] Same Bank RFM
-        case CommandType::DRFMsb: // [DRFM] DRFM Same Bank
-            TriggerSameRankAlert(cmd, clk);
-            UpdateSameBankset(
-                cmd.addr, timing_.same_bankset[static_cast<int>(cmd.cmd_type)],
-                clk);
-            
-            UpdateOtherBanksets(
-                cmd.addr, timing_.other_banksets[static_cast<int>(cmd.cmd_type)],
-                clk);
-            break;
+            return true;
         default:
-            AbruptExit(__FILE__, __LINE__);
+            return false;
     }
+}
+
+constexpr bool IsBanksetTimingCmd(CommandType cmd_type) {
+    return cmd_type == CommandType::REFsb || cmd_type == CommandType::RFMsb ||
+           cmd_type == CommandType::DRFMsb;
+}
+
+constexpr bool IsPrechargeOrAct(CommandType cmd_type) {
+    return cmd_type == CommandType::ACTIVATE ||
+           cmd_type == CommandType::READ_PRECHARGE ||
+           cmd_type == CommandType::WRITE_PRECHARGE ||
+           cmd_type == CommandType::PRECHARGE ||
+           cmd_type == CommandType::PREab || cmd_type == CommandType::PREsb;
+}
+
+}  // namespace
+
+template <CommandType kCmd, bool kMultiRank>
+void ChannelState::UpdateTimingKernel(const Command& cmd, uint64_t clk) {
+    constexpr int kIdx = static_cast<int>(kCmd);
+    if constexpr (IsBankTimingCmd(kCmd)) {
+        if constexpr (kCmd == CommandType::ACTIVATE) {
+            num_acts_abo_++;
+            UpdateActivationTimes(cmd.Rank(), clk);
+        }
+        if constexpr (IsPrechargeOrAct(kCmd)) {
+            TriggerSameBankAlert(cmd, clk);
+        }
+        UpdateSameBankTiming(cmd.addr, timing_.same_bank[kIdx], clk);
+        UpdateOtherBanksSameBankgroupTiming(
+            cmd.addr, timing_.other_banks_same_bankgroup[kIdx], clk);
+        UpdateOtherBankgroupsSameRankTiming(
+            cmd.addr, timing_.other_bankgroups_same_rank[kIdx], clk);
+        if constexpr (kMultiRank) {
+            UpdateOtherRanksTiming(cmd.addr, timing_.other_ranks[kIdx], clk);
+        }
+    } else if constexpr (IsRankTimingCmd(kCmd)) {
+        if constexpr (kCmd == CommandType::RFMab) {  // [RFM] All Bank RFM
+            num_acts_abo_ = 0;
+        }
+        if constexpr (kCmd == CommandType::RFMab ||
+                      kCmd == CommandType::REFab) {
+            TriggerSameRankAlert(cmd, clk);
+        }
+        UpdateSameRankTiming(cmd.addr, timing_.same_rank[kIdx], clk);
+    } else if constexpr (IsBanksetTimingCmd(kCmd)) {
+        TriggerSameRankAlert(cmd, clk);
+        UpdateSameBankset(cmd.addr, timing_.same_bankset[kIdx], clk);
+        UpdateOtherBanksets(cmd.addr, timing_.other_banksets[kIdx], clk);
+    } else {
+        AbruptExit(__FILE__, __LINE__);
+    }
+    return;
+}
+
+template <bool kMultiRank>
+void ChannelState::InitUpdateTimingFns() {
+    auto& fns = update_timing_fns_;
+    fns[static_cast<int>(CommandType::READ)] =
+        &ChannelState::UpdateTimingKernel<CommandType::READ, kMultiRank>;
+    fns[static_cast<int>(CommandType::READ_PRECHARGE)] =
+        &ChannelState::UpdateTimingKernel<CommandType::READ_PRECHARGE, kMultiRank>;
+    fns[static_cast<int>(CommandType::WRITE)] =
+        &ChannelState::UpdateTimingKernel<CommandType::WRITE, kMultiRank>;
+    fns[static_cast<int>(CommandType::WRITE_PRECHARGE)] =
+        &ChannelState::UpdateTimingKernel<CommandType::WRITE_PRECHARGE, kMultiRank>;
+    fns[static_cast<int>(CommandType::ACTIVATE)] =
+        &ChannelState::UpdateTimingKernel<CommandType::ACTIVATE, kMultiRank>;
+    fns[static_cast<int>(CommandType::PRECHARGE)] =
+        &ChannelState::UpdateTimingKernel<CommandType::PRECHARGE, kMultiRank>;
+    fns[static_cast<int>(CommandType::REFRESH_BANK)] =
+        &ChannelState::UpdateTimingKernel<CommandType::REFRESH_BANK, kMultiRank>;
+    fns[static_cast<int>(CommandType::REFsb)] =
+        &ChannelState::UpdateTimingKernel<CommandType::REFsb, kMultiRank>;
+    fns[static_cast<int>(CommandType::REFab)] =
+        &ChannelState::UpdateTimingKernel<CommandType::REFab, kMultiRank>;
+    fns[static_cast<int>(CommandType::SREF_ENTER)] =
+        &ChannelState::UpdateTimingKernel<CommandType::SREF_ENTER, kMultiRank>;
+    fns[static_cast<int>(CommandType::SREF_EXIT)] =
+        &ChannelState::UpdateTimingKernel<CommandType::SREF_EXIT, kMultiRank>;
+    fns[static_cast<int>(CommandType::RFMsb)] =
+        &ChannelState::UpdateTimingKernel<CommandType::RFMsb, kMultiRank>;
+    fns[static_cast<int>(CommandType::RFMab)] =
+        &ChannelState::UpdateTimingKernel<CommandType::RFMab, kMultiRank>;
+    fns[static_cast<int>(CommandType::DRFMb)] =
+        &ChannelState::UpdateTimingKernel<CommandType::DRFMb, kMultiRank>;
+    fns[static_cast<int>(CommandType::DRFMsb)] =
+        &ChannelState::UpdateTimingKernel<CommandType::DRFMsb, kMultiRank>;
+    fns[static_cast<int>(CommandType::DRFMab)] =
+        &ChannelState::UpdateTimingKernel<CommandType::DRFMab, kMultiRank>;
+    fns[static_cast<int>(CommandType::PREab)] =
+        &ChannelState::UpdateTimingKernel<CommandType::PREab, kMultiRank>;
+    fns[static_cast<int>(CommandType::PREsb)] =
+        &ChannelState::UpdateTimingKernel<CommandType::PREsb, kMultiRank>;
+    fns[static_cast<int>(CommandType::SIZE)] =
+        &ChannelState::UpdateTimingKernel<CommandType::SIZE, kMultiRank>;
+    return;
+}
+
+void ChannelState::UpdateTiming(const Command& cmd, uint64_t clk)
+{
+    (this->*update_timing_fns_[static_cast<int>(cmd.cmd_type)])(cmd, clk);
     return;
 }
 
 void ChannelState::UpdateSameBankset(
     const Address& addr,
-    const std::vector<std::pair<CommandType, int>>& cmd_timing_list,
+    const TimingList& cmd_timing_list,
     uint64_t clk) {
-    for (auto j = 0; j < config_.bankgroups; j++) {
-        for (auto cmd_timing : cmd_timing_list) {
-            bank_states_[addr.rank][j][addr.bank].UpdateTiming(
-                cmd_timing.first, clk + cmd_timing.second);
-        }
+    int first = addr.rank * config_.banks + addr.bank;
+    for (auto cmd_timing : cmd_timing_list) {
+        bank_timing_.UpdateStrided(cmd_timing.first, first,
+                                   config_.banks_per_group, config_.bankgroups,
+                                   clk + cmd_timing.second);
     }
     return;
 }
 
 void ChannelState::UpdateOtherBanksets(
     const Address& addr,
-    const std::vector<std::pair<CommandType, int>>& cmd_timing_list,
+    const TimingList& cmd_timing_list,
     uint64_t clk) {
-    for (auto i = 0; i < config_.ranks; i++) {
-        for (auto j = 0; j < config_.bankgroups; j++) {
-            for (auto k = 0; k < config_.banks_per_group; k++) {
-                if (k == addr.bank)
-                {
-                    continue;
-                }
-                for (auto cmd_timing : cmd_timing_list) {
-                    bank_states_[i][j][k].UpdateTiming(
-                        cmd_timing.first, clk + cmd_timing.second);
-                }
-            }
+    int num_groups = config_.ranks * config_.bankgroups;
+    for (auto cmd_timing : cmd_timing_list) {
+        for (int g = 0; g < num_groups; g++) {
+            int first = g * config_.banks_per_group;
+            bank_timing_.UpdateSpan(cmd_timing.first, first, first + addr.bank,
+                                    clk + cmd_timing.second);
+            bank_timing_.UpdateSpan(cmd_timing.first, first + addr.bank + 1,
+                                    first + config_.banks_per_group,
+                                    clk + cmd_timing.second);
         }
     }
     return;
@@ -1058,77 +1342,72 @@ void ChannelState::UpdateOtherBanksets(
 
 void ChannelState::UpdateSameBankTiming(
     const Address& addr,
-    const std::vector<std::pair<CommandType, int>>& cmd_timing_list,
+    const TimingList& cmd_timing_list,
     uint64_t clk) {
+    int bank_id = BankIndex(addr.rank, addr.bankgroup, addr.bank);
     for (auto cmd_timing : cmd_timing_list) {
-        bank_states_[addr.rank][addr.bankgroup][addr.bank].UpdateTiming(
-            cmd_timing.first, clk + cmd_timing.second);
+        bank_timing_.Update(cmd_timing.first, bank_id, clk + cmd_timing.second);
     }
     return;
 }
 
 void ChannelState::UpdateOtherBanksSameBankgroupTiming(
     const Address& addr,
-    const std::vector<std::pair<CommandType, int>>& cmd_timing_list,
+    const TimingList& cmd_timing_list,
     uint64_t clk) {
-    for (auto k = 0; k < config_.banks_per_group; k++) {
-        if (k != addr.bank) {
-            for (auto cmd_timing : cmd_timing_list) {
-                bank_states_[addr.rank][addr.bankgroup][k].UpdateTiming(
-                    cmd_timing.first, clk + cmd_timing.second);
-            }
-        }
+    int first = BankIndex(addr.rank, addr.bankgroup, 0);
+    int bank_id = first + addr.bank;
+    for (auto cmd_timing : cmd_timing_list) {
+        bank_timing_.UpdateSpan(cmd_timing.first, first, bank_id,
+                                clk + cmd_timing.second);
+        bank_timing_.UpdateSpan(cmd_timing.first, bank_id + 1,
+                                first + config_.banks_per_group,
+                                clk + cmd_timing.second);
     }
     return;
 }
 
 void ChannelState::UpdateOtherBankgroupsSameRankTiming(
     const Address& addr,
-    const std::vector<std::pair<CommandType, int>>& cmd_timing_list,
+    const TimingList& cmd_timing_list,
     uint64_t clk) {
-    for (auto j = 0; j < config_.bankgroups; j++) {
-        if (j != addr.bankgroup) {
-            for (auto k = 0; k < config_.banks_per_group; k++) {
-                for (auto cmd_timing : cmd_timing_list) {
-                    bank_states_[addr.rank][j][k].UpdateTiming(
-                        cmd_timing.first, clk + cmd_timing.second);
-                }
-            }
-        }
+    int rank_first = BankIndex(addr.rank, 0, 0);
+    int bg_first = BankIndex(addr.rank, addr.bankgroup, 0);
+    for (auto cmd_timing : cmd_timing_list) {
+        bank_timing_.UpdateSpan(cmd_timing.first, rank_first, bg_first,
+                                clk + cmd_timing.second);
+        bank_timing_.UpdateSpan(cmd_timing.first,
+                                bg_first + config_.banks_per_group,
+                                rank_first + config_.banks,
+                                clk + cmd_timing.second);
     }
     return;
 }
 
 void ChannelState::UpdateOtherRanksTiming(
     const Address& addr,
-    const std::vector<std::pair<CommandType, int>>& cmd_timing_list,
+    const TimingList& cmd_timing_list,
     uint64_t clk) {
-    for (auto i = 0; i < config_.ranks; i++) {
-        if (i != addr.rank) {
-            for (auto j = 0; j < config_.bankgroups; j++) {
-                for (auto k = 0; k < config_.banks_per_group; k++) {
-                    for (auto cmd_timing : cmd_timing_list) {
-                        bank_states_[i][j][k].UpdateTiming(
-                            cmd_timing.first, clk + cmd_timing.second);
-                    }
-                }
-            }
-        }
+    int rank_first = BankIndex(addr.rank, 0, 0);
+    for (auto cmd_timing : cmd_timing_list) {
+        bank_timing_.UpdateSpan(cmd_timing.first, 0, rank_first,
+                                clk + cmd_timing.second);
+        bank_timing_.UpdateSpan(cmd_timing.first, rank_first + config_.banks,
+                                config_.ranks * config_.banks,
+                                clk + cmd_timing.second);
     }
     return;
 }
 
 void ChannelState::UpdateSameRankTiming(
     const Address& addr,
-    const std::vector<std::pair<CommandType, int>>& cmd_timing_list,
+    const TimingList& cmd_timing_list,
     uint64_t clk) {
-    for (auto j = 0; j < config_.bankgroups; j++) {
-        for (auto k = 0; k < config_.banks_per_group; k++) {
-            for (auto cmd_timing : cmd_timing_list) {
-                bank_states_[addr.rank][j][k].UpdateTiming(
-                    cmd_timing.first, clk + cmd_timing.second);
-            }
-        }
+    int rank_first = BankIndex(addr.rank, 0, 0);
+    for (auto cmd_timing : cmd_timing_list) {
+        bank_timing_.UpdateSpan(cmd_timing.first, rank_first,
+                                rank_first + config_.banks,
+                                clk + cmd_timing.second);
     }
     return;
 }
@@ -1159,37 +1438,19 @@ bool ChannelState::ActivationWindowOk(int rank, uint64_t curr_time) const {
 }
 
 void ChannelState::UpdateActivationTimes(int rank, uint64_t curr_time) {
-    if (!four_aw_[rank].empty() && curr_time >= four_aw_[rank][0]) {
-        four_aw_[rank].erase(four_aw_[rank].begin());
-    }
-    four_aw_[rank].push_back(curr_time + config_.tFAW);
+    four_aw_[rank].Add(curr_time);
     if (config_.IsGDDR()) {
-        if (!thirty_two_aw_[rank].empty() &&
-            curr_time >= thirty_two_aw_[rank][0]) {
-            thirty_two_aw_[rank].erase(thirty_two_aw_[rank].begin());
-        }
-        thirty_two_aw_[rank].push_back(curr_time + config_.t32AW);
+        thirty_two_aw_[rank].Add(curr_time);
     }
     return;
 }
 
 bool ChannelState::IsFAWReady(int rank, uint64_t curr_time) const {
-    if (!four_aw_[rank].empty()) {
-        if (curr_time < four_aw_[rank][0] && four_aw_[rank].size() >= 4) {
-            return false;
-        }
-    }
-    return true;
+    return four_aw_[rank].Ready(curr_time);
 }
 
 bool ChannelState::Is32AWReady(int rank, uint64_t curr_time) const {
-    if (!thirty_two_aw_[rank].empty()) {
-        if (curr_time < thirty_two_aw_[rank][0] &&
-            thirty_two_aw_[rank].size() >= 32) {
-            return false;
-        }
-    }
-    return true;
+    return thirty_two_aw_[rank].Ready(curr_time);
 }
 
 }  // namespace dramsim3
@@ -1,39 +1,33 @@
 #ifndef __CHANNEL_STATE_H
 #define __CHANNEL_STATE_H
 
+#include <array>
 #include <vector>
 #include <string>
 #include <sstream>
 #include "bankstate.h"
 #include "common.h"
 #include "configuration.h"
+#include "ring_buffer.h"
+#include "rolling_window.h"
+#include "row_count_cache.h"
 #include "timing.h"
 #include "simple_stats.h"
+#include "state_io.h"
 
 
 namespace dramsim3 {
 
-// [ABACUS]
-struct ABACUS_Entry {
-    uint32_t rac;
-    uint64_t sav;
-
-    ABACUS_Entry(uint32_t a, uint64_t s) : rac(a), sav(s) {}
-    ABACUS_Entry() : rac(0), sav(0) {}
-
-
-    std::string to_string() const
-    {
-        std::stringstream ss;
-        ss << " RAC: " << rac << " SAV: " << std::hex << sav << std::dec;
-        return ss.str();
-    }
-};
-
 class ChannelState {
    public:
     ChannelState(const Config& config, const Timing& timing, SimpleStats& simple_stats, int channel);
     Command GetReadyCommand(const Command& cmd, uint64_t clk) const;
+    // lower bound on the cycle GetReadyCommand() can return anything for a
+    // queued read/write, valid until the state of its bank changes
+    uint64_t EarliestReadyCycle(const Command& cmd) const {
+        return bank_states_[cmd.Rank()][cmd.Bankgroup()][cmd.Bank()]
+            .EarliestReadyCycle(cmd);
+    }
     void UpdateState(const Command& cmd, uint64_t clk);
     void UpdateTiming(const Command& cmd, uint64_t clk);
     void UpdateTimingAndStates(const Command& cmd, uint64_t clk);
@@ -61,11 +55,15 @@ class ChannelState {
     bool IsRFMWaiting() const { return !rfm_q_.empty(); }
     const Command& PendingRFMCommand() const {return rfm_q_.front(); }
 
-    // [Hydra]
-    bool HydraRead(int rank, int bankgroup, int bank, int row);
+    // [Hydra] counter reads (and write-backs while draining) go ahead of the
+    // regular commands, other write-backs only fill in idle cycles
+    bool HydraRead(int waiter, int rank, int bankgroup, int bank, int row);
     void HydraWB(int rank, int bankgroup, int bank, int row);
     Command GetReadyHydraCommand(uint64_t clk) const;
-    bool hydra_wb_draining_;
+    Command GetIdleHydraCommand(uint64_t clk) const;
+    bool IsHydraPending() const {
+        return !hydra_rd_q_.empty() or !hydra_wb_q_.empty();
+    }
     
     int OpenRow(int rank, int bankgroup, int bank) const {
         return bank_states_[rank][bankgroup][bank].OpenRow();
@@ -85,51 +83,106 @@ class ChannelState {
 
     std::vector<int> rank_idle_cycles;
 
+    // hold back stdout output (e.g. DREAM telemetry) until FlushOutput() so
+    // channels ticked on different threads print in channel order
+    void DeferOutput(bool defer) { defer_output_ = defer; }
+    void FlushOutput();
+
+    void Checkpoint(StateIO& io);
+
    private:
     const Config& config_;
     const Timing& timing_;
     SimpleStats& simple_stats_;
     int channel_;
+    int num_alerts_stat_;
+    int bursty_access_count_stat_;
+
+    bool defer_output_;
+    std::string deferred_output_;
 
     // [Tracking]
     uint64_t last_bus_access_time_;
     uint64_t bursty_access_count_;
 
     std::vector<bool> rank_is_sref_;
+    BankTiming bank_timing_;
     std::vector<std::vector<std::vector<BankState> > > bank_states_;
     std::vector<Command> refresh_q_;
     std::vector<Command> rfm_q_; // [RFM]
-    std::vector<Command> hydra_rd_q_; // [Hydra]
+    // [Hydra] counter read and the banks whose ACT waits for it
+    struct HydraFetch {
+        Command cmd;
+        std::vector<int> waiters;
+
+        void Checkpoint(StateIO& io) { io(cmd, waiters); }
+    };
+    // [Hydra] per bank, the ACT waiting for its counter(s) and the cycle the
+    // last of them arrives, row is the one whose counter was fetched
+    struct HydraWait {
+        HydraWait() : fetches(0), ready_clk(0), row(-1) {}
+        int fetches;
+        uint64_t ready_clk;
+        int row;
+    };
+    std::vector<HydraFetch> hydra_rd_q_; // [Hydra]
     std::vector<Command> hydra_wb_q_; // [Hydra]
+    bool hydra_wb_draining_; // [Hydra]
+    std::vector<HydraWait> hydra_waits_; // [Hydra]
+    RowCountCache hydra_rcc_; // [Hydra]
+    Command GetReadyHydraWB(uint64_t clk);
 
     // [REF]
     uint32_t ref_idx_;
     uint32_t fgr_counter_;
     void UpdateREFCounter(Command& cmd);
 
-    std::vector<std::vector<uint64_t> > four_aw_;
-    std::vector<std::vector<uint64_t> > thirty_two_aw_;
+    std::vector<RollingWindow> four_aw_;
+    std::vector<RollingWindow> thirty_two_aw_;
     bool IsFAWReady(int rank, uint64_t curr_time) const;
     bool Is32AWReady(int rank, uint64_t curr_time) const;
     
     // [DREAM]
-    std::string dream_resets_stat_;
+    int dream_resets_stat_;
     std::vector<uint32_t> tusc_; // Table of Untagged Skewed Counters
     std::vector<uint32_t> tusc_prev_; // Table of Untagged Skewed Counters
     std::vector<uint32_t> random_masks;
     uint32_t tusc_size_;
-    std::vector<uint32_t> tusc_q_; // Queue of tusc_idx
+    // [DREAM] telemetry (dream_mode = 0), number of tusc_ entries at each
+    // count, kept up to date by dream_preact() so dream_refresh() needs no sort
+    std::vector<uint64_t> tusc_count_hist_;
+    uint64_t tusc_sum_;
+    RingBuffer<uint32_t> tusc_q_; // Queue of tusc_idx
     uint32_t get_tusc_idx(uint32_t rank, uint32_t bankgroup, uint32_t bank, uint32_t rowid) const;
-    uint32_t get_row_idx(uint32_t rank, uint32_t bankgroup, uint32_t bank, uint32_t tuscid, uint32_t row_num) const;
+    std::vector<uint32_t> dream_fanout_xor_;
+    std::vector<uint32_t> dream_fanout_add_;
+    std::vector<uint32_t> dream_fanout_rows_; // rows to DRFM per (bank, row_num)
+    void dream_fanout(uint32_t tusc_idx);
     void dream_preact(uint32_t rank, uint32_t bankgroup, uint32_t bank, uint32_t rowid);
     void dream_refresh();
     void dream_mitig();
 
-    // [ABACUS]
+    // [ABACUS] per row activation counter (RAC) and the sharer vector (SAV)
+    // of the banks that activated the row since its RAC last went up. A SAV
+    // takes abacus_sav_words_ words, the preact kernel is instantiated for
+    // that width. A refresh resets its chunk of rows by bumping the chunk's
+    // epoch, rows tagged with an older epoch read as zero.
+    struct ABACUS_Entry {
+        ABACUS_Entry() : rac(0), epoch(0) {}
+        uint32_t rac;
+        uint32_t epoch;
+    };
     std::vector<ABACUS_Entry> abacus_table_;
-    std::vector<uint32_t> abacus_q_;
+    std::vector<uint64_t> abacus_sav_;
+    int abacus_sav_words_;
+    std::vector<uint32_t> abacus_chunk_epoch_; // refchunks + 1, the last one for rows no refresh covers
+    uint32_t abacus_rows_per_ref_;
+    RingBuffer<uint32_t> abacus_q_;
     uint32_t abacus_entries_;
-    std::string abacus_resets_stat_;
+    int abacus_resets_stat_;
+    bool (ChannelState::*abacus_preact_fn_)(uint32_t bank_idx, uint32_t rowid);
+    template <int kWords>
+    bool AbacusPreactKernel(uint32_t bank_idx, uint32_t rowid);
     void abacus_preact(uint32_t rank, uint32_t bankgroup, uint32_t bank, uint32_t rowid);
     void abacus_refresh();
     void abacus_mitig();
@@ -144,45 +197,61 @@ class ChannelState {
 
     void UpdateREFCounter(const Command& cmd);
 
+    // UpdateTiming() dispatches through a kernel per command type, picked
+    // once from the config (single rank configs skip the other ranks update)
+    using UpdateTimingFn = void (ChannelState::*)(const Command&, uint64_t);
+    std::array<UpdateTimingFn, static_cast<int>(CommandType::SIZE) + 1>
+        update_timing_fns_;
+    template <bool kMultiRank>
+    void InitUpdateTimingFns();
+    template <CommandType kCmd, bool kMultiRank>
+    void UpdateTimingKernel(const Command& cmd, uint64_t clk);
+
+    // flat bank id used by bank_timing_
+    int BankIndex(int rank, int bankgroup, int bank) const {
+        return rank * config_.banks + bankgroup * config_.banks_per_group +
+               bank;
+    }
+
     void UpdateSameBankset(
         const Address& addr,
-        const std::vector<std::pair<CommandType, int> >& cmd_timing_list,
+        const TimingList& cmd_timing_list,
         uint64_t clk);
     
     void UpdateOtherBanksets(
         const Address& addr,
-        const std::vector<std::pair<CommandType, int> >& cmd_timing_list,
+        const TimingList& cmd_timing_list,
         uint64_t clk);
 
     // Update timing of the bank the command corresponds to    
     void UpdateSameBankTiming(
         const Address& addr,
-        const std::vector<std::pair<CommandType, int> >& cmd_timing_list,
+        const TimingList& cmd_timing_list,
         uint64_t clk);
 
     // Update timing of the other banks in the same bankgroup as the command
     void UpdateOtherBanksSameBankgroupTiming(
         const Address& addr,
-        const std::vector<std::pair<CommandType, int> >& cmd_timing_list,
+        const TimingList& cmd_timing_list,
         uint64_t clk);
 
     // Update timing of banks in the same rank but different bankgroup as the
     // command
     void UpdateOtherBankgroupsSameRankTiming(
         const Address& addr,
-        const std::vector<std::pair<CommandType, int> >& cmd_timing_list,
+        const TimingList& cmd_timing_list,
         uint64_t clk);
 
     // Update timing of banks in a different rank as the command
     void UpdateOtherRanksTiming(
         const Address& addr,
-        const std::vector<std::pair<CommandType, int> >& cmd_timing_list,
+        const TimingList& cmd_timing_list,
         uint64_t clk);
 
     // Update timing of the entire rank (for rank level commands)
     void UpdateSameRankTiming(
         const Address& addr,
-        const std::vector<std::pair<CommandType, int> >& cmd_timing_list,
+        const TimingList& cmd_timing_list,
         uint64_t clk);
 };
 
@@ -9,11 +9,15 @@ CommandQueue::CommandQueue(int channel_id, const Config& config,
       config_(config),
       channel_state_(channel_state),
       simple_stats_(simple_stats),
+      num_ondemand_pres_stat_(simple_stats.GetStatId("num_ondemand_pres")),
       is_in_ref_(false),
       is_in_rfm_(false),
       queue_size_(static_cast<size_t>(config_.cmd_queue_size)),
       queue_idx_(0),
-      clk_(0) {
+      clk_(0),
+      next_wake_(std::numeric_limits<uint64_t>::max()),
+      bank_seen_(config.ranks * config.banks, 0),
+      scan_id_(0) {
     if (config_.queue_structure == "PER_BANK") {
         queue_structure_ = QueueStructure::PER_BANK;
         num_queues_ = config_.banks * config_.ranks;
@@ -32,31 +36,76 @@ CommandQueue::CommandQueue(int channel_id, const Config& config,
         cmd_queue.reserve(config_.cmd_queue_size);
         queues_.push_back(cmd_queue);
     }
+
+    ready_queues_.resize((num_queues_ + 63) / 64, 0);
+    sleeping_queues_.resize((num_queues_ + 63) / 64, 0);
+    wake_cycle_.resize(num_queues_, 0);
 }
 
 Command CommandQueue::GetCommandToIssue() {
-    for (int i = 0; i < num_queues_; i++) {
-        auto& queue = GetNextQueue();
-        // if we're refresing, skip the command queues that are involved
-        if (is_in_ref_) {
-            if (ref_q_indices_.find(queue_idx_) != ref_q_indices_.end()) {
-                continue;
-            }
+    // [Hydra] counter reads (and write-backs while draining) go first, the
+    // other write-backs take the cycles no queued command can use
+    if (config_.hydra_mode != 0) {
+        Command cmd = channel_state_.GetReadyHydraCommand(clk_);
+        if (!cmd.IsValid()) {
+            cmd = GetQueuedCommandToIssue();
+        }
+        if (!cmd.IsValid()) {
+            cmd = channel_state_.GetIdleHydraCommand(clk_);
         }
+        return cmd;
+    }
+    return GetQueuedCommandToIssue();
+}
 
-        if (is_in_rfm_) {
-            if (rfm_q_indices_.find(queue_idx_) != rfm_q_indices_.end()) {
-                continue;
+Command CommandQueue::GetQueuedCommandToIssue() {
+    if (clk_ >= next_wake_) {
+        WakeSleepingQueues();
+    }
+
+    // round robin over the queues, starting after the one served last, the
+    // queues not marked ready could not return a command anyway
+    int start = queue_idx_ + 1 == num_queues_ ? 0 : queue_idx_ + 1;
+    bool wrapped = false;
+    int q_idx = NextReadyQueue(start);
+    while (true) {
+        if (q_idx < 0) {
+            if (wrapped || start == 0) {
+                break;
             }
+            wrapped = true;
+            q_idx = NextReadyQueue(0);
+            continue;
         }
+        if (wrapped && q_idx >= start) {
+            break;
+        }
+
+        bool skip = (is_in_ref_ &&
+                     ref_q_indices_.find(q_idx) != ref_q_indices_.end()) ||
+                    (is_in_rfm_ &&
+                     rfm_q_indices_.find(q_idx) != rfm_q_indices_.end());
+        if (!skip) {
+            auto& queue = queues_[q_idx];
+            auto cmd = GetFirstReadyInQueue(queue);
+            if (cmd.IsValid()) {
+                queue_idx_ = q_idx;
+                if (cmd.IsReadWrite()) {
+                    EraseRWCommand(cmd);
+                }
+                return cmd;
+            }
 
-        auto cmd = GetFirstReadyInQueue(queue);
-        if (cmd.IsValid()) {
-            if (cmd.IsReadWrite()) {
-                EraseRWCommand(cmd);
+            uint64_t wake_cycle = std::numeric_limits<uint64_t>::max();
+            for (const auto& queued : queue) {
+                wake_cycle = std::min(wake_cycle,
+                                      channel_state_.EarliestReadyCycle(queued));
+            }
+            if (wake_cycle > clk_) {
+                SleepQueue(q_idx, wake_cycle);
             }
-            return cmd;
         }
+        q_idx = NextReadyQueue(q_idx + 1);
     }
     return Command();
 }
@@ -105,35 +154,25 @@ Command CommandQueue::FinishRFM() {
 }
 
 bool CommandQueue::ArbitratePrecharge(const CMDIterator& cmd_it,
-                                      const CMDQueue& queue) const {
+                                      bool bank_seen) const {
     auto cmd = *cmd_it;
 
-    for (auto prev_itr = queue.begin(); prev_itr != cmd_it; prev_itr++) {
-        if (prev_itr->Rank() == cmd.Rank() &&
-            prev_itr->Bankgroup() == cmd.Bankgroup() &&
-            prev_itr->Bank() == cmd.Bank()) {
-            return false;
-        }
+    // an earlier command to the same bank goes first
+    if (bank_seen) {
+        return false;
     }
 
-    bool pending_row_hits_exist = false;
+    // so every queued command to the bank is at or after cmd_it
     int open_row =
         channel_state_.OpenRow(cmd.Rank(), cmd.Bankgroup(), cmd.Bank());
-    for (auto pending_itr = cmd_it; pending_itr != queue.end(); pending_itr++) {
-        if (pending_itr->Row() == open_row &&
-            pending_itr->Bank() == cmd.Bank() &&
-            pending_itr->Bankgroup() == cmd.Bankgroup() &&
-            pending_itr->Rank() == cmd.Rank()) {
-            pending_row_hits_exist = true;
-            break;
-        }
-    }
+    bool pending_row_hits_exist =
+        row_cmd_counts_.count(RowKey(cmd, open_row)) > 0;
 
     bool rowhit_limit_reached =
         channel_state_.RowHitCount(cmd.Rank(), cmd.Bankgroup(), cmd.Bank()) >=
         4;
     if (!pending_row_hits_exist || rowhit_limit_reached) {
-        simple_stats_.Increment("num_ondemand_pres");
+        simple_stats_.Increment(num_ondemand_pres_stat_);
         return true;
     }
     return false;
@@ -145,7 +184,7 @@ bool CommandQueue::WillAcceptCommand(int rank, int bankgroup, int bank) const {
 }
 
 bool CommandQueue::QueueEmpty() const {
-    for (const auto q : queues_) {
+    for (const auto& q : queues_) {
         if (!q.empty()) {
             return false;
         }
@@ -158,19 +197,100 @@ bool CommandQueue::AddCommand(Command cmd) {
     auto& queue = GetQueue(cmd.Rank(), cmd.Bankgroup(), cmd.Bank());
     if (queue.size() < queue_size_) {
         queue.push_back(cmd);
+        CountCommand(cmd, 1);
         rank_q_empty[cmd.Rank()] = false;
+        MarkReady(GetQueueIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank()));
         return true;
     } else {
         return false;
     }
 }
 
-CMDQueue& CommandQueue::GetNextQueue() {
-    queue_idx_++;
-    if (queue_idx_ == num_queues_) {
-        queue_idx_ = 0;
+void CommandQueue::WakeQueues(const Command& cmd) {
+    if (queue_structure_ == QueueStructure::PER_BANK &&
+        (cmd.IsRankCMD() || cmd.IsSbCMD())) {
+        for (int i = 0; i < config_.banks; i++) {
+            int q_idx = cmd.Rank() * config_.banks + i;
+            if (!queues_[q_idx].empty()) {
+                MarkReady(q_idx);
+            }
+        }
+    } else {
+        int q_idx = GetQueueIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank());
+        if (!queues_[q_idx].empty()) {
+            MarkReady(q_idx);
+        }
+    }
+}
+
+void CommandQueue::Checkpoint(StateIO& io) {
+    io(rank_q_empty, queues_, ref_q_indices_, is_in_ref_, rfm_q_indices_,
+       is_in_rfm_, queue_idx_, clk_, ready_queues_, sleeping_queues_,
+       wake_cycle_, next_wake_, row_cmd_counts_, read_counts_, bank_seen_,
+       scan_id_);
+}
+
+void CommandQueue::CountCommand(const Command& cmd, int delta) {
+    auto it = row_cmd_counts_.emplace(RowKey(cmd, cmd.Row()), 0).first;
+    it->second += delta;
+    if (it->second == 0) {
+        row_cmd_counts_.erase(it);
+    }
+    if (cmd.IsRead()) {
+        it = read_counts_.emplace(ColumnKey(cmd), 0).first;
+        it->second += delta;
+        if (it->second == 0) {
+            read_counts_.erase(it);
+        }
+    }
+}
+
+int CommandQueue::NextReadyQueue(int from) const {
+    if (from >= num_queues_) {
+        return -1;
+    }
+    size_t word = from / 64;
+    uint64_t bits = ready_queues_[word] & (~0ULL << (from % 64));
+    while (bits == 0) {
+        if (++word == ready_queues_.size()) {
+            return -1;
+        }
+        bits = ready_queues_[word];
+    }
+    return word * 64 + __builtin_ctzll(bits);
+}
+
+void CommandQueue::MarkReady(int q_idx) {
+    ready_queues_[q_idx / 64] |= 1ULL << (q_idx % 64);
+    sleeping_queues_[q_idx / 64] &= ~(1ULL << (q_idx % 64));
+}
+
+void CommandQueue::MarkIdle(int q_idx) {
+    ready_queues_[q_idx / 64] &= ~(1ULL << (q_idx % 64));
+    sleeping_queues_[q_idx / 64] &= ~(1ULL << (q_idx % 64));
+}
+
+void CommandQueue::SleepQueue(int q_idx, uint64_t wake_cycle) {
+    ready_queues_[q_idx / 64] &= ~(1ULL << (q_idx % 64));
+    sleeping_queues_[q_idx / 64] |= 1ULL << (q_idx % 64);
+    wake_cycle_[q_idx] = wake_cycle;
+    next_wake_ = std::min(next_wake_, wake_cycle);
+}
+
+void CommandQueue::WakeSleepingQueues() {
+    next_wake_ = std::numeric_limits<uint64_t>::max();
+    for (size_t word = 0; word < sleeping_queues_.size(); word++) {
+        uint64_t bits = sleeping_queues_[word];
+        while (bits != 0) {
+            int q_idx = word * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            if (wake_cycle_[q_idx] <= clk_) {
+                MarkReady(q_idx);
+            } else {
+                next_wake_ = std::min(next_wake_, wake_cycle_[q_idx]);
+            }
+        }
     }
-    return queues_[queue_idx_];
 }
 
 void CommandQueue::GetRefQIndices(const Command& ref) {
@@ -249,19 +369,23 @@ CMDQueue& CommandQueue::GetQueue(int rank, int bankgroup, int bank) {
     return queues_[index];
 }
 
-Command CommandQueue::GetFirstReadyInQueue(CMDQueue& queue) const {
+Command CommandQueue::GetFirstReadyInQueue(CMDQueue& queue) {
+    scan_id_++;
     for (auto cmd_it = queue.begin(); cmd_it != queue.end(); cmd_it++) {
-        Command hydra_cmd = channel_state_.GetReadyHydraCommand(clk_);
-        if (hydra_cmd.IsValid()) {
-            return hydra_cmd;
+        // all commands of a PER_BANK queue go to the same bank
+        bool bank_seen = cmd_it != queue.begin();
+        if (queue_structure_ == QueueStructure::PER_RANK) {
+            uint64_t& seen = bank_seen_[BankIndex(*cmd_it)];
+            bank_seen = seen == scan_id_;
+            seen = scan_id_;
         }
-        
+
         Command cmd = channel_state_.GetReadyCommand(*cmd_it, clk_);
         if (!cmd.IsValid()) {
             continue;
         }
         if (cmd.cmd_type == CommandType::PRECHARGE) {
-            if (!ArbitratePrecharge(cmd_it, queue)) {
+            if (!ArbitratePrecharge(cmd_it, bank_seen)) {
                 continue;
             }
         } else if (cmd.IsWrite()) {
@@ -278,7 +402,11 @@ void CommandQueue::EraseRWCommand(const Command& cmd) {
     auto& queue = GetQueue(cmd.Rank(), cmd.Bankgroup(), cmd.Bank());
     for (auto cmd_it = queue.begin(); cmd_it != queue.end(); cmd_it++) {
         if (cmd.hex_addr == cmd_it->hex_addr && cmd.cmd_type == cmd_it->cmd_type) {
+            CountCommand(*cmd_it, -1);
             queue.erase(cmd_it);
+            if (queue.empty()) {
+                MarkIdle(GetQueueIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank()));
+            }
             return;
         }
     }
@@ -304,6 +432,9 @@ bool CommandQueue::HasRWDependency(const CMDIterator& cmd_it,
                                    const CMDQueue& queue) const {
     // Read after write has been checked in controller so we only
     // check write after read here
+    if (read_counts_.count(ColumnKey(*cmd_it)) == 0) {
+        return false;
+    }
     for (auto it = queue.begin(); it != cmd_it; it++) {
         if (it->IsRead() && it->Row() == cmd_it->Row() &&
             it->Column() == cmd_it->Column() && it->Bank() == cmd_it->Bank() &&
@@ -1,13 +1,16 @@
 #ifndef __COMMAND_QUEUE_H
 #define __COMMAND_QUEUE_H
 
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <cassert>
+#include <limits>
 #include "channel_state.h"
 #include "common.h"
 #include "configuration.h"
 #include "simple_stats.h"
+#include "state_io.h"
 
 namespace dramsim3 {
 
@@ -23,21 +26,31 @@ class CommandQueue {
     Command FinishRefresh();
     Command FinishRFM(); // [RFM] All Bank RFM
     void ClockTick() { clk_ += 1; };
+    void AdvanceTo(uint64_t clk) { clk_ = clk; }
     bool WillAcceptCommand(int rank, int bankgroup, int bank) const;
     bool AddCommand(Command cmd);
     bool QueueEmpty() const;
     int QueueUsage() const;
+    // cmd changed the state of the banks it was issued to, let their queues
+    // be scanned again
+    void WakeQueues(const Command& cmd);
+    void Checkpoint(StateIO& io);
     std::vector<bool> rank_q_empty;
 
    private:
     bool ArbitratePrecharge(const CMDIterator& cmd_it,
-                            const CMDQueue& queue) const;
+                            bool bank_seen) const;
     bool HasRWDependency(const CMDIterator& cmd_it,
                          const CMDQueue& queue) const;
-    Command GetFirstReadyInQueue(CMDQueue& queue) const;
+    Command GetFirstReadyInQueue(CMDQueue& queue);
     int GetQueueIndex(int rank, int bankgroup, int bank) const;
     CMDQueue& GetQueue(int rank, int bankgroup, int bank);
-    CMDQueue& GetNextQueue();
+    Command GetQueuedCommandToIssue();
+    int NextReadyQueue(int from) const;
+    void MarkReady(int q_idx);
+    void MarkIdle(int q_idx);
+    void SleepQueue(int q_idx, uint64_t wake_cycle);
+    void WakeSleepingQueues();
     void GetRefQIndices(const Command& ref);
     void GetRFMQIndices(const Command& rfm); // [RFM] All Bank RFM
     void EraseRWCommand(const Command& cmd);
@@ -46,6 +59,7 @@ class CommandQueue {
     const Config& config_;
     const ChannelState& channel_state_;
     SimpleStats& simple_stats_;
+    int num_ondemand_pres_stat_;
 
     std::vector<CMDQueue> queues_;
 
@@ -61,6 +75,40 @@ class CommandQueue {
     size_t queue_size_;
     int queue_idx_;
     uint64_t clk_;
+
+    // bitmaps over the queues: ready ones are non-empty and may have a
+    // command to issue, sleeping ones are non-empty but none of their
+    // commands can be ready before wake_cycle_ (bank timing only grows, so
+    // this only changes when a new command arrives or a bank changes state)
+    std::vector<uint64_t> ready_queues_;
+    std::vector<uint64_t> sleeping_queues_;
+    std::vector<uint64_t> wake_cycle_;
+    uint64_t next_wake_;
+
+    // queued commands per (bank, row) and queued reads per (bank, row,
+    // column), so precharge arbitration and write after read checks don't
+    // have to walk the queue
+    std::unordered_map<uint64_t, int> row_cmd_counts_;
+    std::unordered_map<uint64_t, int> read_counts_;
+    void CountCommand(const Command& cmd, int delta);
+    int BankIndex(const Command& cmd) const {
+        return cmd.Rank() * config_.banks +
+               cmd.Bankgroup() * config_.banks_per_group + cmd.Bank();
+    }
+    uint64_t RowKey(const Command& cmd, int row) const {
+        return (static_cast<uint64_t>(BankIndex(cmd)) << 32) |
+               static_cast<uint32_t>(row);
+    }
+    uint64_t ColumnKey(const Command& cmd) const {
+        return (static_cast<uint64_t>(BankIndex(cmd)) << 48) |
+               (static_cast<uint64_t>(static_cast<uint32_t>(cmd.Row())) << 16) |
+               static_cast<uint16_t>(cmd.Column());
+    }
+
+    // banks seen so far while walking a PER_RANK queue, a bank has been seen
+    // if its entry equals the current scan_id_
+    std::vector<uint64_t> bank_seen_;
+    uint64_t scan_id_;
 };
 
 }  // namespace dramsim3
@@ -135,7 +135,8 @@ struct Command {
 };
 
 struct Transaction {
-    Transaction() {}
+    Transaction()
+        : addr(0), added_cycle(0), complete_cycle(0), is_write(false) {}
     Transaction(uint64_t addr, bool is_write)
         : addr(addr),
           added_cycle(0),
@@ -145,11 +146,14 @@ struct Transaction {
         : addr(tran.addr),
           added_cycle(tran.added_cycle),
           complete_cycle(tran.complete_cycle),
-          is_write(tran.is_write) {}
+          is_write(tran.is_write),
+          decoded_addr(tran.decoded_addr) {}
     uint64_t addr;
     uint64_t added_cycle;
     uint64_t complete_cycle;
     bool is_write;
+    // addr mapped to channel/rank/..., filled in by Controller::AddTransaction
+    Address decoded_addr;
 
     friend std::ostream& operator<<(std::ostream& os, const Transaction& trans);
     friend std::istream& operator>>(std::istream& is, Transaction& trans);
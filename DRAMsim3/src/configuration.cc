@@ -3,6 +3,10 @@
 #include <vector>
 #include <cassert>
 
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif  // __BMI2__
+
 #ifdef THERMAL
 #include <math.h>
 #endif  // THERMAL
@@ -43,17 +47,29 @@ Config::Config(std::string config_file, std::string out_dir)
 
 Address Config::AddressMapping(uint64_t hex_addr) const {
     hex_addr >>= shift_bits;
+#ifdef __BMI2__
+    int channel = _pext_u64(hex_addr, ch_field);
+    int rank = _pext_u64(hex_addr, ra_field);
+    int bg = _pext_u64(hex_addr, bg_field);
+    int ba = _pext_u64(hex_addr, ba_field);
+    int ro = _pext_u64(hex_addr, ro_field);
+    if (co_single_field) {
+        int co = _pext_u64(hex_addr, co_field);
+        return Address(channel, rank, bg, ba, ro, co);
+    }
+#else
     int channel = (hex_addr >> ch_pos) & ch_mask;
     int rank = (hex_addr >> ra_pos) & ra_mask;
     int bg = (hex_addr >> bg_pos) & bg_mask;
     int ba = (hex_addr >> ba_pos) & ba_mask;
     int ro = (hex_addr >> ro_pos) & ro_mask;
+#endif  // __BMI2__
     int co;
     if (mop_enabled)
     {
         int hi = (hex_addr >> hi_pos) & hi_mask;
         int lo = (hex_addr >> lo_pos) & lo_mask;
-        co = (hi << LogBase2(mop_size)) | lo;
+        co = (hi << mop_shift) | lo;
     }
     else
     {
@@ -259,6 +275,7 @@ void Config::InitOtherParams() {
     // 1: default value, adds epoch CSV output on level 0
     // 2: adds histogram outputs in a different CSV format
     output_level = reader.GetInteger("other", "output_level", 1);
+    seed = reader.GetInteger("other", "seed", 0);
     // Other Parameters
     // give a prefix instead of specify the output name one by one...
     // this would allow outputing to a directory and you can always override
@@ -363,6 +380,7 @@ void Config::InitSystemParams() {
     sref_threshold = GetInteger("system", "sref_threshold", 1000);
     aggressive_precharging_enabled =
         reader.GetBoolean("system", "aggressive_precharging_enabled", false);
+    channel_threads = GetInteger("system", "channel_threads", 1);
 
     return;
 }
@@ -557,6 +575,24 @@ void Config::SetAddressMapping() {
         co_mask = (1 << field_widths.at("co")) - 1;
     }
 
+    ch_field = ch_mask << ch_pos;
+    ra_field = ra_mask << ra_pos;
+    bg_field = bg_mask << bg_pos;
+    ba_field = ba_mask << ba_pos;
+    ro_field = ro_mask << ro_pos;
+    mop_shift = LogBase2(mop_size);
+    if (mop_enabled)
+    {
+        // PEXT packs the low field first, only right if hi sits above lo
+        co_field = (hi_mask << hi_pos) | (lo_mask << lo_pos);
+        co_single_field = hi_pos > lo_pos;
+    }
+    else
+    {
+        co_field = co_mask << co_pos;
+        co_single_field = true;
+    }
+
     std::cout << "[DRAM] Channel Position: " << ch_pos << "| Width: " << field_widths.at("ch") << std::endl;
     std::cout << "[DRAM] Rank Position: " << ra_pos << "| Width: " << field_widths.at("ra") << std::endl;
     std::cout << "[DRAM] BankGroup Position: " << bg_pos << "| Width: " << field_widths.at("bg") << std::endl;
@@ -762,17 +798,25 @@ void Config::InitHYDRAParams() {
     hydra_rcc_sets = reader.GetInteger("hydra", "hydra_rcc_sets", 1);
     hydra_rcc_ways = reader.GetInteger("hydra", "hydra_rcc_ways", 1);
     hydra_wbq_size = reader.GetInteger("hydra", "hydra_wbq_size", 32);
+    hydra_wbq_low = reader.GetInteger("hydra", "hydra_wbq_low", hydra_wbq_size / 2);
 
     std::cout << "[HYDRA] hydra_mode: " << hydra_mode << std::endl;
     if (hydra_mode != 0)
     {
-        hydra_rcc.update_size(hydra_rcc_sets, hydra_rcc_ways);
+        // the RCC keeps its per set valid/dirty/PLRU state in 64 bit masks
+        if (hydra_rcc_ways < 1 or hydra_rcc_ways > 64 or hydra_rcc_sets < 1)
+        {
+            std::cerr << "[HYDRA] hydra_rcc_ways must be in [1, 64] and "
+                         "hydra_rcc_sets at least 1" << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
         std::cout << "[HYDRA] hydra_th: " << hydra_th << std::endl;
         std::cout << "[HYDRA] hydra_gct_size: " << hydra_gct_size << std::endl;
         std::cout << "[HYDRA] hydra_gct_th: " << hydra_gct_th << std::endl;
         std::cout << "[HYDRA] hydra_rcc_sets: " << hydra_rcc_sets << std::endl;
         std::cout << "[HYDRA] hydra_rcc_ways: " << hydra_rcc_ways << std::endl;
         std::cout << "[HYDRA] hydra_wbq_size: " << hydra_wbq_size << std::endl;
+        std::cout << "[HYDRA] hydra_wbq_low: " << hydra_wbq_low << std::endl;
     }
     return;
 }
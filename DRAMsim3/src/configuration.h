@@ -6,7 +6,6 @@
 #include "common.h"
 
 #include "INIReader.h"
-#include "lru.hpp"
 
 namespace dramsim3 {
 
@@ -67,6 +66,11 @@ class Config {
     int shift_bits;
     int ch_pos, ra_pos, bg_pos, ba_pos, ro_pos, co_pos, hi_pos, lo_pos;
     uint64_t ch_mask, ra_mask, bg_mask, ba_mask, ro_mask, co_mask, hi_mask, lo_mask;
+    // the same fields as masks in place (after shift_bits) for PEXT, the
+    // column is one field unless MOP puts its high bits below the low ones
+    uint64_t ch_field, ra_field, bg_field, ba_field, ro_field, co_field;
+    bool co_single_field;
+    int mop_shift;
 
     // Generic DRAM timing parameters
     double tCK;
@@ -155,6 +159,7 @@ class Config {
     int sref_threshold;
     bool aggressive_precharging_enabled;
     bool enable_hbm_dual_cmd;
+    int channel_threads;      // threads ticking the channel controllers
 
 
     // [RFM] parameters
@@ -214,8 +219,8 @@ class Config {
     int hydra_gct_th;
     int hydra_rcc_sets;
     int hydra_rcc_ways;
-    int hydra_wbq_size;
-    LRUCache hydra_rcc;
+    int hydra_wbq_size; // write-backs start draining at this many
+    int hydra_wbq_low; // and stop once down to this many
 
     // [ABACUS] parameters
     int abacus_mode;
@@ -223,6 +228,8 @@ class Config {
 
     int epoch_period;
     int output_level;
+    // seeds the per bank (PARA, MINT) and per channel (DREAM) generators
+    uint64_t seed;
     std::string output_dir;
     std::string output_prefix;
     std::string json_stats_name;
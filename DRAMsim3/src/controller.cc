@@ -1,4 +1,6 @@
 #include "controller.h"
+#include <assert.h>
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <limits>
@@ -15,6 +17,20 @@ Controller::Controller(int channel, const Config &config, const Timing &timing)
       clk_(0),
       config_(config),
       simple_stats_(config_, channel_id_),
+      num_cycles_id_(simple_stats_.GetStatId("num_cycles")),
+      num_reads_done_id_(simple_stats_.GetStatId("num_reads_done")),
+      num_writes_done_id_(simple_stats_.GetStatId("num_writes_done")),
+      num_read_row_hits_id_(simple_stats_.GetStatId("num_read_row_hits")),
+      num_write_row_hits_id_(simple_stats_.GetStatId("num_write_row_hits")),
+      hbm_dual_cmds_id_(simple_stats_.GetStatId("hbm_dual_cmds")),
+      sref_cycles_id_(simple_stats_.GetVecStatId("sref_cycles")),
+      all_bank_idle_cycles_id_(
+          simple_stats_.GetVecStatId("all_bank_idle_cycles")),
+      rank_active_cycles_id_(simple_stats_.GetVecStatId("rank_active_cycles")),
+      read_latency_id_(simple_stats_.GetHistoStatId("read_latency")),
+      write_latency_id_(simple_stats_.GetHistoStatId("write_latency")),
+      interarrival_latency_id_(
+          simple_stats_.GetHistoStatId("interarrival_latency")),
       channel_state_(config, timing, simple_stats_, channel_id_),
       cmd_queue_(channel_id_, config, channel_state_, simple_stats_),
       refresh_(config, channel_state_),
@@ -22,9 +38,40 @@ Controller::Controller(int channel, const Config &config, const Timing &timing)
       thermal_calc_(thermal_calc),
 #endif  // THERMAL
       is_unified_queue_(config.unified_queue),
+      pending_rd_q_(config.trans_queue_size),
+      pending_wr_q_(config.trans_queue_size),
+      return_queue_(std::max(config.read_delay, 1)),
+      done_idx_(0),
+      done_clk_(std::numeric_limits<uint64_t>::max()),
       row_buf_policy_(config.row_buf_policy),
       last_trans_clk_(0),
       write_draining_(0) {
+    const std::pair<CommandType, const char *> cmd_stats[] = {
+        {CommandType::READ, "num_read_cmds"},
+        {CommandType::READ_PRECHARGE, "num_read_cmds"},
+        {CommandType::WRITE, "num_write_cmds"},
+        {CommandType::WRITE_PRECHARGE, "num_write_cmds"},
+        {CommandType::ACTIVATE, "num_act_cmds"},
+        {CommandType::PRECHARGE, "num_pre_cmds"},
+        {CommandType::REFRESH_BANK, "num_refb_cmds"},
+        {CommandType::REFsb, "num_refsb_cmds"},
+        {CommandType::REFab, "num_refab_cmds"},
+        {CommandType::SREF_ENTER, "num_srefe_cmds"},
+        {CommandType::SREF_EXIT, "num_srefx_cmds"},
+        {CommandType::RFMsb, "num_rfmsb_cmds"},
+        {CommandType::RFMab, "num_rfmab_cmds"},
+        {CommandType::DRFMb, "num_drfmb_cmds"},
+        {CommandType::DRFMsb, "num_drfmsb_cmds"},
+        {CommandType::DRFMab, "num_drfmab_cmds"},
+        {CommandType::PREab, "num_preab_cmds"},
+        {CommandType::PREsb, "num_presb_cmds"},
+    };
+    cmd_stat_ids_.fill(-1);
+    for (const auto &it : cmd_stats) {
+        cmd_stat_ids_[static_cast<int>(it.first)] =
+            simple_stats_.GetStatId(it.second);
+    }
+
     if (is_unified_queue_) {
         unified_queue_.reserve(config_.trans_queue_size);
     } else {
@@ -41,25 +88,31 @@ Controller::Controller(int channel, const Config &config, const Timing &timing)
 }
 
 std::pair<uint64_t, int> Controller::ReturnDoneTrans(uint64_t clk) {
-    auto it = return_queue_.begin();
-    while (it != return_queue_.end()) {
-        if (clk >= it->complete_cycle) {
-            if (it->is_write) {
-                simple_stats_.Increment("num_writes_done");
-            } else {
-                simple_stats_.Increment("num_reads_done");
-                simple_stats_.AddValue("read_latency", clk_ - it->added_cycle);
-            }
-            auto pair = std::make_pair(it->addr, it->is_write);
-            it = return_queue_.erase(it);
-            return pair;
+    if (done_clk_ != clk) {
+        CollectDoneTrans(clk);
+    }
+    if (done_idx_ < done_trans_.size()) {
+        const auto &trans = done_trans_[done_idx_++];
+        if (trans.is_write) {
+            simple_stats_.Increment(num_writes_done_id_);
         } else {
-            ++it;
+            simple_stats_.Increment(num_reads_done_id_);
+            simple_stats_.AddValue(read_latency_id_, clk_ - trans.added_cycle);
         }
+        return std::make_pair(trans.addr, trans.is_write);
     }
+    done_trans_.clear();
+    done_idx_ = 0;
     return std::make_pair(-1, -1);
 }
 
+void Controller::CollectDoneTrans(uint64_t clk) {
+    // anything added after this point cannot complete before clk + 1
+    return_queue_.Collect(clk, done_trans_);
+    done_clk_ = clk;
+    return;
+}
+
 void Controller::ClockTick() {
     // update refresh counter
     refresh_.ClockTick();
@@ -86,7 +139,7 @@ void Controller::ClockTick() {
             if (second_cmd.IsValid()) {
                 if (second_cmd.IsReadWrite() != cmd.IsReadWrite()) {
                     IssueCommand(second_cmd);
-                    simple_stats_.Increment("hbm_dual_cmds");
+                    simple_stats_.Increment(hbm_dual_cmds_id_);
                 }
             }
         }
@@ -95,14 +148,14 @@ void Controller::ClockTick() {
     // power updates pt 1
     for (int i = 0; i < config_.ranks; i++) {
         if (channel_state_.IsRankSelfRefreshing(i)) {
-            simple_stats_.IncrementVec("sref_cycles", i);
+            simple_stats_.IncrementVec(sref_cycles_id_, i);
         } else {
             bool all_idle = channel_state_.IsAllBankIdleInRank(i);
             if (all_idle) {
-                simple_stats_.IncrementVec("all_bank_idle_cycles", i);
+                simple_stats_.IncrementVec(all_bank_idle_cycles_id_, i);
                 channel_state_.rank_idle_cycles[i] += 1;
             } else {
-                simple_stats_.IncrementVec("rank_active_cycles", i);
+                simple_stats_.IncrementVec(rank_active_cycles_id_, i);
                 // reset
                 channel_state_.rank_idle_cycles[i] = 0;
             }
@@ -144,10 +197,92 @@ void Controller::ClockTick() {
     ScheduleTransaction();
     clk_++;
     cmd_queue_.ClockTick();
-    simple_stats_.Increment("num_cycles");
+    simple_stats_.Increment(num_cycles_id_);
+    return;
+}
+
+uint64_t Controller::NextEventCycle() const {
+    // anything queued or waiting on refresh/RFM may become issuable as
+    // soon as a bank's cmd_timing_ allows it, so step through those
+    if (channel_state_.IsRefreshWaiting() || channel_state_.IsRFMWaiting() ||
+        channel_state_.IsHydraPending() || !cmd_queue_.QueueEmpty() ||
+        done_idx_ < done_trans_.size()) {
+        return clk_;
+    }
+
+    // a few writes can sit in the write buffer without being scheduled,
+    // see the draining thresholds in ScheduleTransaction()
+    if (is_unified_queue_) {
+        if (!unified_queue_.empty()) {
+            return clk_;
+        }
+    } else if (!read_queue_.empty()) {
+        return clk_;
+    } else if (!write_buffer_.empty() &&
+               (write_draining_ > 0 || write_buffer_.size() > 8 ||
+                write_buffer_.size() >= write_buffer_.capacity())) {
+        return clk_;
+    }
+
+    uint64_t next = refresh_.NextRefreshCycle();
+    if (!return_queue_.Empty()) {
+        next = std::min(next, std::max(return_queue_.NextCycle(), clk_));
+    }
+
+    // idle ranks may enter self-refresh once they hit the threshold, and a
+    // rank in self-refresh with commands seen keeps trying to exit
+    if (config_.enable_self_refresh) {
+        for (int i = 0; i < config_.ranks; i++) {
+            if (channel_state_.IsRankSelfRefreshing(i)) {
+                if (!cmd_queue_.rank_q_empty[i]) {
+                    return clk_;
+                }
+            } else if (cmd_queue_.rank_q_empty[i] &&
+                       channel_state_.IsAllBankIdleInRank(i)) {
+                int64_t left = static_cast<int64_t>(config_.sref_threshold) -
+                               channel_state_.rank_idle_cycles[i] - 1;
+                next = std::min(next, clk_ + std::max<int64_t>(left, 0));
+            }
+        }
+    }
+    return next;
+}
+
+void Controller::AdvanceTo(uint64_t clk) {
+    assert(clk <= NextEventCycle());
+    if (clk <= clk_) {
+        return;
+    }
+    uint64_t cycles = clk - clk_;
+
+    // bulk version of the power updates in ClockTick, nothing is issued so
+    // the bank states do not change along the way
+    for (int i = 0; i < config_.ranks; i++) {
+        if (channel_state_.IsRankSelfRefreshing(i)) {
+            simple_stats_.IncrementVecBy(sref_cycles_id_, i, cycles);
+        } else if (channel_state_.IsAllBankIdleInRank(i)) {
+            simple_stats_.IncrementVecBy(all_bank_idle_cycles_id_, i, cycles);
+            channel_state_.rank_idle_cycles[i] += cycles;
+        } else {
+            simple_stats_.IncrementVecBy(rank_active_cycles_id_, i, cycles);
+            channel_state_.rank_idle_cycles[i] = 0;
+        }
+    }
+
+    refresh_.AdvanceTo(clk);
+    cmd_queue_.AdvanceTo(clk);
+    clk_ = clk;
+    simple_stats_.Increment(num_cycles_id_, cycles);
     return;
 }
 
+void Controller::Checkpoint(StateIO &io) {
+    io(clk_, simple_stats_, channel_state_, cmd_queue_, refresh_,
+       unified_queue_, read_queue_, write_buffer_, pending_rd_q_,
+       pending_wr_q_, return_queue_, done_trans_, done_idx_, done_clk_,
+       last_trans_clk_, write_draining_, trans_row_counts_);
+}
+
 bool Controller::IsInDRFM(uint64_t hex_addr) const {
     auto addr = config_.AddressMapping(hex_addr);
     return channel_state_.IsInDRFM(addr.rank, addr.bankgroup, addr.bank);
@@ -170,12 +305,14 @@ bool Controller::WillAcceptTransaction(uint64_t hex_addr, bool is_write) const {
 
 bool Controller::AddTransaction(Transaction trans) {
     trans.added_cycle = clk_;
-    simple_stats_.AddValue("interarrival_latency", clk_ - last_trans_clk_);
+    trans.decoded_addr = config_.AddressMapping(trans.addr);
+    simple_stats_.AddValue(interarrival_latency_id_, clk_ - last_trans_clk_);
     last_trans_clk_ = clk_;
 
     if (trans.is_write) {
-        if (pending_wr_q_.count(trans.addr) == 0) {  // can not merge writes
-            pending_wr_q_.insert(std::make_pair(trans.addr, trans));
+        if (pending_wr_q_.Count(trans.addr) == 0) {  // can not merge writes
+            pending_wr_q_.Insert(trans);
+            CountTransRow(trans, 1);
             if (is_unified_queue_) {
                 unified_queue_.push_back(trans);
             } else {
@@ -183,17 +320,17 @@ bool Controller::AddTransaction(Transaction trans) {
             }
         }
         trans.complete_cycle = clk_ + 1;
-        return_queue_.push_back(trans);
+        return_queue_.Push(trans);
         return true;
     } else {  // read
         // if in write buffer, use the write buffer value
-        if (pending_wr_q_.count(trans.addr) > 0) {
+        if (pending_wr_q_.Count(trans.addr) > 0) {
             trans.complete_cycle = clk_ + 1;
-            return_queue_.push_back(trans);
+            return_queue_.Push(trans);
             return true;
         }
-        pending_rd_q_.insert(std::make_pair(trans.addr, trans));
-        if (pending_rd_q_.count(trans.addr) == 1) {
+        if (pending_rd_q_.Insert(trans) == 1) {
+            CountTransRow(trans, 1);
             if (is_unified_queue_) {
                 unified_queue_.push_back(trans);
             } else {
@@ -218,18 +355,20 @@ void Controller::ScheduleTransaction() {
         is_unified_queue_ ? unified_queue_
                           : write_draining_ > 0 ? write_buffer_ : read_queue_;
     for (auto it = queue.begin(); it != queue.end(); it++) {
-        auto cmd = TransToCommand(it, queue);
-        if (cmd_queue_.WillAcceptCommand(cmd.Rank(), cmd.Bankgroup(),
-                                         cmd.Bank())) {
+        const auto &addr = it->decoded_addr;
+        if (cmd_queue_.WillAcceptCommand(addr.rank, addr.bankgroup,
+                                         addr.bank)) {
+            auto cmd = TransToCommand(*it);
             if (!is_unified_queue_ && cmd.IsWrite()) {
                 // Enforce R->W dependency
-                if (pending_rd_q_.count(it->addr) > 0) {
+                if (pending_rd_q_.Count(it->addr) > 0) {
                     write_draining_ = 0;
                     break;
                 }
                 write_draining_ -= 1;
             }
             cmd_queue_.AddCommand(cmd);
+            CountTransRow(*it, -1);
             queue.erase(it);
             break;
         }
@@ -247,39 +386,35 @@ void Controller::IssueCommand(const Command &cmd) {
 
     // if read/write, update pending queue and return queue
     if (cmd.IsRead() and cmd.hex_addr != -1) { // hex_addr == -1 for Hydra commands
-        auto num_reads = pending_rd_q_.count(cmd.hex_addr);
+        // if there are multiple reads pending return them all
+        auto num_reads =
+            pending_rd_q_.Remove(cmd.hex_addr, [this](Transaction &trans) {
+                trans.complete_cycle = clk_ + config_.read_delay;
+                return_queue_.Push(trans);
+            });
         if (num_reads == 0) {
             std::cerr << cmd.hex_addr << " not in read queue! " << std::endl;
             exit(1);
         }
-        // if there are multiple reads pending return them all
-        while (num_reads > 0) {
-            auto it = pending_rd_q_.find(cmd.hex_addr);
-            it->second.complete_cycle = clk_ + config_.read_delay;
-            return_queue_.push_back(it->second);
-            pending_rd_q_.erase(it);
-            num_reads -= 1;
-        }
     } else if (cmd.IsWrite() and cmd.hex_addr != -1) { // hex_addr == -1 for Hydra commands
         // there should be only 1 write to the same location at a time
-        auto it = pending_wr_q_.find(cmd.hex_addr);
-        if (it == pending_wr_q_.end()) {
+        auto trans = pending_wr_q_.Front(cmd.hex_addr);
+        if (trans == nullptr) {
             std::cerr << cmd.hex_addr << " not in write queue!" << std::endl;
             exit(1);
         }
-        auto wr_lat = clk_ - it->second.added_cycle + config_.write_delay;
-        simple_stats_.AddValue("write_latency", wr_lat);
-        pending_wr_q_.erase(it);
+        auto wr_lat = clk_ - trans->added_cycle + config_.write_delay;
+        simple_stats_.AddValue(write_latency_id_, wr_lat);
+        pending_wr_q_.Remove(cmd.hex_addr);
     }
     // must update stats before states (for row hits)
     UpdateCommandStats(cmd);
     channel_state_.UpdateTimingAndStates(cmd, clk_);
+    cmd_queue_.WakeQueues(cmd);
 }
 
-Command Controller::TransToCommand(const TransIterator &trans_it, const TransQueue &queue) {
-    auto trans = *trans_it;
-    auto addr = config_.AddressMapping(trans.addr);
-    
+Command Controller::TransToCommand(const Transaction &trans) {
+    const auto &addr = trans.decoded_addr;
     // OPEN_PAGE
     CommandType cmd_type = trans.is_write ? CommandType::WRITE : CommandType::READ;
     
@@ -291,18 +426,12 @@ Command Controller::TransToCommand(const TransIterator &trans_it, const TransQue
     else if (row_buf_policy_ == RowBufPolicy::SOFT_CLOSE_PAGE)
     {
         // if there is a request to the same row in the queue, we issue a
-        // read/write command, otherwise we issue a read/write precharge
-        bool request_exist = false;
-        for (auto pending_itr = std::next(trans_it); pending_itr != queue.end(); pending_itr++) {
-            auto pending_addr = config_.AddressMapping(pending_itr->addr);
-            if (pending_addr.row == addr.row &&
-                pending_addr.rank == addr.rank &&
-                pending_addr.bankgroup == addr.bankgroup &&
-                pending_addr.bank == addr.bank) {
-                request_exist = true;
-                break;
-            }
-        }
+        // read/write command, otherwise we issue a read/write precharge.
+        // Only the first transaction to a bank can be accepted by the command
+        // queue, so any other one to the row is behind this one
+        auto row_count = trans_row_counts_.find(TransRowKey(trans.is_write, addr));
+        bool request_exist =
+            row_count != trans_row_counts_.end() && row_count->second > 1;
 
         if (request_exist)
         {
@@ -317,6 +446,26 @@ Command Controller::TransToCommand(const TransIterator &trans_it, const TransQue
     return Command(cmd_type, addr, trans.addr);
 }
 
+uint64_t Controller::TransRowKey(bool is_write, const Address &addr) const {
+    // reads and writes are only in the same queue when it is unified
+    uint64_t bank = addr.rank * config_.banks +
+                    addr.bankgroup * config_.banks_per_group + addr.bank;
+    uint64_t queue = is_unified_queue_ ? 0 : is_write;
+    return (queue << 63) | (bank << 32) | static_cast<uint32_t>(addr.row);
+}
+
+void Controller::CountTransRow(const Transaction &trans, int delta) {
+    if (row_buf_policy_ != RowBufPolicy::SOFT_CLOSE_PAGE) {
+        return;
+    }
+    auto key = TransRowKey(trans.is_write, trans.decoded_addr);
+    auto it = trans_row_counts_.emplace(key, 0).first;
+    it->second += delta;
+    if (it->second == 0) {
+        trans_row_counts_.erase(it);
+    }
+}
+
 int Controller::QueueUsage() const { return cmd_queue_.QueueUsage(); }
 
 void Controller::PrintEpochStats() {
@@ -349,67 +498,16 @@ void Controller::PrintDeadlock() const {
 }
 
 void Controller::UpdateCommandStats(const Command &cmd) {
-    switch (cmd.cmd_type) {
-        case CommandType::READ:
-        case CommandType::READ_PRECHARGE:
-            simple_stats_.Increment("num_read_cmds");
-            if (channel_state_.RowHitCount(cmd.Rank(), cmd.Bankgroup(),
-                                           cmd.Bank()) != 0) {
-                simple_stats_.Increment("num_read_row_hits");
-            }
-            break;
-        case CommandType::WRITE:
-        case CommandType::WRITE_PRECHARGE:
-            simple_stats_.Increment("num_write_cmds");
-            if (channel_state_.RowHitCount(cmd.Rank(), cmd.Bankgroup(),
-                                           cmd.Bank()) != 0) {
-                simple_stats_.Increment("num_write_row_hits");
-            }
-            break;
-        case CommandType::PREab:
-            simple_stats_.Increment("num_preab_cmds");
-            break;
-        case CommandType::PREsb:
-            simple_stats_.Increment("num_presb_cmds");
-            break;
-        case CommandType::ACTIVATE:
-            simple_stats_.Increment("num_act_cmds");
-            break;
-        case CommandType::RFMab:
-            simple_stats_.Increment("num_rfmab_cmds");
-            break;
-        case CommandType::RFMsb:
-            simple_stats_.Increment("num_rfmsb_cmds");
-            break;
-        case CommandType::DRFMab:
-            simple_stats_.Increment("num_drfmab_cmds");
-            break;
-        case CommandType::DRFMsb:
-            simple_stats_.Increment("num_drfmsb_cmds");
-            break;
-        case CommandType::DRFMb:
-            simple_stats_.Increment("num_drfmb_cmds");
-            break;
-        case CommandType::PRECHARGE:
-            simple_stats_.Increment("num_pre_cmds");
-            break;
-        case CommandType::REFab:
-            simple_stats_.Increment("num_refab_cmds");
-            break;
-        case CommandType::REFsb:
-            simple_stats_.Increment("num_refsb_cmds");
-            break;
-        case CommandType::REFRESH_BANK:
-            simple_stats_.Increment("num_refb_cmds");
-            break;
-        case CommandType::SREF_ENTER:
-            simple_stats_.Increment("num_srefe_cmds");
-            break;
-        case CommandType::SREF_EXIT:
-            simple_stats_.Increment("num_srefx_cmds");
-            break;
-        default:
-            AbruptExit(__FILE__, __LINE__);
+    int id = cmd.IsValid() ? cmd_stat_ids_[static_cast<int>(cmd.cmd_type)] : -1;
+    if (id < 0) {
+        AbruptExit(__FILE__, __LINE__);
+    }
+    simple_stats_.Increment(id);
+    if (cmd.IsReadWrite() &&
+        channel_state_.RowHitCount(cmd.Rank(), cmd.Bankgroup(), cmd.Bank()) !=
+            0) {
+        simple_stats_.Increment(cmd.IsRead() ? num_read_row_hits_id_
+                                             : num_write_row_hits_id_);
     }
 }
 
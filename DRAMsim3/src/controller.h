@@ -1,8 +1,10 @@
 #ifndef __CONTROLLER_H
 #define __CONTROLLER_H
 
+#include <array>
 #include <fstream>
 #include <map>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include "channel_state.h"
@@ -10,6 +12,8 @@
 #include "common.h"
 #include "refresh.h"
 #include "simple_stats.h"
+#include "state_io.h"
+#include "trans_table.h"
 
 #ifdef THERMAL
 #include "thermal.h"
@@ -29,6 +33,12 @@ class Controller {
     Controller(int channel, const Config &config, const Timing &timing);
 #endif  // THERMAL
     void ClockTick();
+    // earliest cycle at which ClockTick() may do more than count cycles,
+    // returns clk_ if the next tick has to be simulated
+    uint64_t NextEventCycle() const;
+    // fast forward to clk without stepping, clk must not be past
+    // NextEventCycle()
+    void AdvanceTo(uint64_t clk);
     bool WillAcceptTransaction(uint64_t hex_addr, bool is_write) const;
     bool AddTransaction(Transaction trans);
     int QueueUsage() const;
@@ -38,8 +48,15 @@ class Controller {
     void ResetStats() { simple_stats_.Reset(); }
     void PrintDeadlock() const;
     std::pair<uint64_t, int> ReturnDoneTrans(uint64_t clock);
+    // move transactions done by clock out of the return queue so that
+    // ReturnDoneTrans(clock) only has to hand them out, stats are updated
+    // when they are handed out
+    void CollectDoneTrans(uint64_t clock);
     bool IsInDRFM(uint64_t hex_addr) const;
     bool IsInREF(uint64_t hex_addr) const;
+    void DeferOutput(bool defer) { channel_state_.DeferOutput(defer); }
+    void FlushOutput() { channel_state_.FlushOutput(); }
+    void Checkpoint(StateIO &io);
 
     int channel_id_;
 
@@ -47,6 +64,22 @@ class Controller {
     uint64_t clk_;
     const Config &config_;
     SimpleStats simple_stats_;
+
+    // ids of the counters updated every cycle / command in simple_stats_
+    std::array<int, static_cast<int>(CommandType::SIZE)> cmd_stat_ids_;
+    int num_cycles_id_;
+    int num_reads_done_id_;
+    int num_writes_done_id_;
+    int num_read_row_hits_id_;
+    int num_write_row_hits_id_;
+    int hbm_dual_cmds_id_;
+    int sref_cycles_id_;
+    int all_bank_idle_cycles_id_;
+    int rank_active_cycles_id_;
+    int read_latency_id_;
+    int write_latency_id_;
+    int interarrival_latency_id_;
+
     ChannelState channel_state_;
     CommandQueue cmd_queue_;
     Refresh refresh_;
@@ -61,12 +94,15 @@ class Controller {
     TransQueue read_queue_;
     TransQueue write_buffer_;
 
-    // transactions that are not completed, use map for convenience
-    std::multimap<uint64_t, Transaction> pending_rd_q_;
-    std::multimap<uint64_t, Transaction> pending_wr_q_;
+    // transactions that are not completed, indexed by address
+    TransTable pending_rd_q_;
+    TransTable pending_wr_q_;
 
     // completed transactions
-    TransQueue return_queue_;
+    TransWheel return_queue_;
+    TransQueue done_trans_;
+    size_t done_idx_;
+    uint64_t done_clk_;
 
     // row buffer policy
     RowBufPolicy row_buf_policy_;
@@ -82,7 +118,12 @@ class Controller {
     int write_draining_;
     void ScheduleTransaction();
     void IssueCommand(const Command &tmp_cmd);
-    Command TransToCommand(const TransIterator &trans_it, const TransQueue &queue);
+    Command TransToCommand(const Transaction &trans);
+
+    // [SOFT_CLOSE_PAGE] number of queued transactions per (queue, bank, row)
+    std::unordered_map<uint64_t, int> trans_row_counts_;
+    uint64_t TransRowKey(bool is_write, const Address &addr) const;
+    void CountTransRow(const Transaction &trans, int delta);
     void UpdateCommandStats(const Command &cmd);
 };
 }  // namespace dramsim3
@@ -1,6 +1,7 @@
 #include "dram_system.h"
 
 #include <assert.h>
+#include <algorithm>
 
 namespace dramsim3 {
 
@@ -33,6 +34,12 @@ int BaseDRAMSystem::GetChannel(uint64_t hex_addr) const {
     return (hex_addr >> config_.ch_pos) & config_.ch_mask;
 }
 
+void BaseDRAMSystem::AdvanceTo(uint64_t clk) {
+    while (clk_ < clk) {
+        ClockTick();
+    }
+}
+
 void BaseDRAMSystem::PrintEpochStats() {
     // first epoch, print bracket
     if (clk_ - config_.epoch_period == 0) {
@@ -92,6 +99,30 @@ void BaseDRAMSystem::ResetStats() {
     }
 }
 
+void BaseDRAMSystem::Checkpoint(StateIO &io) {
+#ifdef THERMAL
+    std::cerr << "Simulator state cannot be saved with THERMAL" << std::endl;
+    AbruptExit(__FILE__, __LINE__);
+#endif  // THERMAL
+    io.Check(std::string("DRAMsim3 state 1"), "format");
+    io.Check(config_.channels, "channels");
+    io.Check(config_.ranks, "ranks");
+    io.Check(config_.bankgroups, "bankgroups");
+    io.Check(config_.banks_per_group, "banks_per_group");
+    io.Check(config_.rows, "rows");
+    io.Check(config_.columns, "columns");
+    io(last_req_clk_, clk_);
+    for (auto ctrl : ctrls_) {
+        io(*ctrl);
+    }
+    // the epochs before clk_ went to the output of the run that saved it,
+    // open the list here
+    if (io.Loading() && clk_ >= static_cast<uint64_t>(config_.epoch_period)) {
+        std::ofstream epoch_out(config_.json_epoch_name, std::ofstream::out);
+        epoch_out << "[";
+    }
+}
+
 void BaseDRAMSystem::RegisterCallbacks(
     std::function<void(uint64_t)> read_callback,
     std::function<void(uint64_t)> write_callback) {
@@ -113,7 +144,12 @@ bool BaseDRAMSystem::IsInREF(uint64_t hex_addr) const {
 JedecDRAMSystem::JedecDRAMSystem(Config &config, const std::string &output_dir,
                                  std::function<void(uint64_t)> read_callback,
                                  std::function<void(uint64_t)> write_callback)
-    : BaseDRAMSystem(config, output_dir, read_callback, write_callback) {
+    : BaseDRAMSystem(config, output_dir, read_callback, write_callback),
+      num_threads_(1),
+      tick_gen_(0),
+      ticks_pending_(0),
+      stop_workers_(false),
+      sleepers_(0) {
     if (config_.IsHMC()) {
         std::cerr << "Initialized a memory system with an HMC config file!"
                   << std::endl;
@@ -128,14 +164,81 @@ JedecDRAMSystem::JedecDRAMSystem(Config &config, const std::string &output_dir,
         ctrls_.push_back(new Controller(i, config_, timing_));
 #endif  // THERMAL
     }
+
+    num_threads_ = std::max(1, std::min(config_.channel_threads, config_.channels));
+    if (num_threads_ > 1 && !ParallelTickSafe()) {
+        std::cout << "[DRAMSim3] channel_threads ignored, enabled "
+                     "mitigations share state across channels"
+                  << std::endl;
+        num_threads_ = 1;
+    }
+    if (num_threads_ > 1) {
+        std::cout << "[DRAMSim3] Ticking " << config_.channels
+                  << " channels on " << num_threads_ << " threads"
+                  << std::endl;
+        for (auto ctrl : ctrls_) {
+            ctrl->DeferOutput(true);
+        }
+        StartWorkers();
+    }
 }
 
 JedecDRAMSystem::~JedecDRAMSystem() {
+    StopWorkers();
     for (auto it = ctrls_.begin(); it != ctrls_.end(); it++) {
         delete (*it);
     }
 }
 
+void JedecDRAMSystem::StopWorkers() {
+    stop_workers_.store(true);
+    WakeSleepers();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    stop_workers_.store(false);
+}
+
+void JedecDRAMSystem::StartWorkers() {
+    if (!workers_.empty()) {
+        return;
+    }
+    // started between ticks, the current generation is already done
+    uint64_t gen = tick_gen_.load();
+    for (int t = 1; t < num_threads_; t++) {
+        workers_.emplace_back(&JedecDRAMSystem::WorkerLoop, this, t, gen);
+    }
+}
+
+// The waker publishes its change (seq_cst) before looking at sleepers_ and
+// a sleeper registers in sleepers_ before its last look at the condition,
+// so either the waker sees the sleeper or the sleeper sees the change.
+template <typename Pred>
+void JedecDRAMSystem::WaitFor(Pred done) {
+    const int kBusySpins = 1024;
+    const int kYieldSpins = 64 * 1024;
+    for (int spins = 0; spins < kYieldSpins; spins++) {
+        if (done()) {
+            return;
+        }
+        if (spins >= kBusySpins) {
+            std::this_thread::yield();
+        }
+    }
+    std::unique_lock<std::mutex> lock(sync_mutex_);
+    sleepers_.fetch_add(1);
+    sync_cv_.wait(lock, done);
+    sleepers_.fetch_sub(1);
+}
+
+void JedecDRAMSystem::WakeSleepers() {
+    if (sleepers_.load() > 0) {
+        std::lock_guard<std::mutex> lock(sync_mutex_);
+        sync_cv_.notify_all();
+    }
+}
+
 bool JedecDRAMSystem::WillAcceptTransaction(uint64_t hex_addr,
                                             bool is_write) const {
     int channel = GetChannel(hex_addr);
@@ -175,8 +278,19 @@ void JedecDRAMSystem::ClockTick() {
             }
         }
     }
-    for (size_t i = 0; i < ctrls_.size(); i++) {
-        ctrls_[i]->ClockTick();
+    if (num_threads_ > 1) {
+        ticks_pending_.store(num_threads_ - 1, std::memory_order_relaxed);
+        tick_gen_.fetch_add(1);
+        WakeSleepers();
+        TickChannels(0);
+        WaitFor([this] { return ticks_pending_.load() == 0; });
+        for (size_t i = 0; i < ctrls_.size(); i++) {
+            ctrls_[i]->FlushOutput();
+        }
+    } else {
+        for (size_t i = 0; i < ctrls_.size(); i++) {
+            ctrls_[i]->ClockTick();
+        }
     }
     clk_++;
 
@@ -186,6 +300,66 @@ void JedecDRAMSystem::ClockTick() {
     return;
 }
 
+bool JedecDRAMSystem::ParallelTickSafe() const {
+#ifdef THERMAL
+    // all channels update the same thermal calculator
+    return false;
+#else
+    return true;
+#endif  // THERMAL
+}
+
+void JedecDRAMSystem::TickChannels(int tid) {
+    for (size_t i = tid; i < ctrls_.size(); i += num_threads_) {
+        ctrls_[i]->ClockTick();
+        // done transactions are only handed out (in channel order) at the
+        // start of the next ClockTick() but can be found here in parallel
+        ctrls_[i]->CollectDoneTrans(clk_ + 1);
+    }
+}
+
+void JedecDRAMSystem::WorkerLoop(int tid, uint64_t seen_gen) {
+    while (true) {
+        WaitFor([this, seen_gen] {
+            return tick_gen_.load() != seen_gen || stop_workers_.load();
+        });
+        if (stop_workers_.load()) {
+            return;
+        }
+        seen_gen = tick_gen_.load();
+        TickChannels(tid);
+        if (ticks_pending_.fetch_sub(1) == 1) {
+            WakeSleepers();
+        }
+    }
+}
+
+void JedecDRAMSystem::AdvanceTo(uint64_t clk) {
+    while (clk_ < clk) {
+        // never jump over an epoch boundary so epoch stats stay the same
+        uint64_t next = std::min(
+            clk, (clk_ / config_.epoch_period + 1) * config_.epoch_period);
+        for (size_t i = 0; i < ctrls_.size(); i++) {
+            next = std::min(next, ctrls_[i]->NextEventCycle());
+        }
+
+        if (next <= clk_) {
+            ClockTick();
+            continue;
+        }
+
+        for (size_t i = 0; i < ctrls_.size(); i++) {
+            ctrls_[i]->AdvanceTo(next);
+        }
+        clk_ = next;
+
+        if (clk_ % config_.epoch_period == 0) {
+            PrintEpochStats();
+        }
+    }
+    return;
+}
+
 IdealDRAMSystem::IdealDRAMSystem(Config &config, const std::string &output_dir,
                                  std::function<void(uint64_t)> read_callback,
                                  std::function<void(uint64_t)> write_callback)
@@ -221,4 +395,9 @@ void IdealDRAMSystem::ClockTick() {
     return;
 }
 
+void IdealDRAMSystem::Checkpoint(StateIO &io) {
+    BaseDRAMSystem::Checkpoint(io);
+    io(infinite_buffer_q_);
+}
+
 }  // namespace dramsim3
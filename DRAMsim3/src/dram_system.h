@@ -1,15 +1,19 @@
 #ifndef __DRAM_SYSTEM_H
 #define __DRAM_SYSTEM_H
 
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "common.h"
 #include "configuration.h"
 #include "controller.h"
+#include "state_io.h"
 #include "timing.h"
-#include "lru.hpp"
 
 #ifdef THERMAL
 #include "thermal.h"
@@ -34,6 +38,14 @@ class BaseDRAMSystem {
                                        bool is_write) const = 0;
     virtual bool AddTransaction(uint64_t hex_addr, bool is_write) = 0;
     virtual void ClockTick() = 0;
+    // equivalent to calling ClockTick() until clk_ reaches clk
+    virtual void AdvanceTo(uint64_t clk);
+    // helper threads do not survive a fork(), stop them before forking and
+    // start them again in the process that goes on ticking
+    virtual void StopWorkers() {}
+    virtual void StartWorkers() {}
+    // saves or loads the state of the controllers, only between ticks
+    virtual void Checkpoint(StateIO &io);
     int GetChannel(uint64_t hex_addr) const;
     bool IsInDRFM(uint64_t hex_addr) const;
     bool IsInREF(uint64_t hex_addr) const;
@@ -71,6 +83,28 @@ public:
     bool WillAcceptTransaction(uint64_t hex_addr, bool is_write) const override;
     bool AddTransaction(uint64_t hex_addr, bool is_write) override;
     void ClockTick() override;
+    void AdvanceTo(uint64_t clk) override;
+    void StopWorkers() override;
+    void StartWorkers() override;
+
+   private:
+    // channel_threads > 1: controllers are ticked on persistent workers,
+    // channel i on thread i % num_threads_ (the calling thread is thread 0)
+    int num_threads_;
+    std::vector<std::thread> workers_;
+    std::atomic<uint64_t> tick_gen_;
+    std::atomic<int> ticks_pending_;
+    std::atomic<bool> stop_workers_;
+    // a waiting thread spins, then yields, then sleeps on sync_cv_
+    std::mutex sync_mutex_;
+    std::condition_variable sync_cv_;
+    std::atomic<int> sleepers_;
+    template <typename Pred>
+    void WaitFor(Pred done);
+    void WakeSleepers();
+    bool ParallelTickSafe() const;
+    void TickChannels(int tid);
+    void WorkerLoop(int tid, uint64_t seen_gen);
 };
 
 // Model a memorysystem with an infinite bandwidth and a fixed latency (possibly
@@ -88,6 +122,7 @@ class IdealDRAMSystem : public BaseDRAMSystem {
     };
     bool AddTransaction(uint64_t hex_addr, bool is_write) override;
     void ClockTick() override;
+    void Checkpoint(StateIO &io) override;
 
    private:
     int latency_;
@@ -0,0 +1,155 @@
+#ifndef __DRFM_SAMPLER_H
+#define __DRFM_SAMPLER_H
+
+#include <cassert>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "state_io.h"
+
+namespace dramsim3 {
+
+// [DRFM] Rows queued for a DRFM in a bank, each with the number of ACTs it
+// got while queued. A row can be queued more than once, only its oldest
+// entry counts ACTs, so the other ones stay at 0 until they become oldest.
+// The mitigation picks the oldest entry with the highest count.
+class DRFMSampler {
+   public:
+    explicit DRFMSampler(size_t capacity)
+        : max_idx_(-1), max_dirty_(false), next_seq_(0), size_(0) {
+        entries_.reserve(capacity);
+        rows_.reserve(capacity);
+    }
+
+    size_t Size() const { return size_; }
+    bool Empty() const { return size_ == 0; }
+
+    void Insert(uint32_t rowid) {
+        int idx;
+        if (free_.empty()) {
+            idx = static_cast<int>(entries_.size());
+            entries_.emplace_back();
+        } else {
+            idx = free_.back();
+            free_.pop_back();
+        }
+        Entry& entry = entries_[idx];
+        entry.rowid = rowid;
+        entry.ctr = 0;
+        entry.seq = next_seq_++;
+        entry.next = -1;
+        entry.live = true;
+        size_++;
+
+        auto it = rows_.find(rowid);
+        if (it == rows_.end()) {
+            rows_.emplace(rowid, RowList{idx, idx});
+        } else {
+            entries_[it->second.tail].next = idx;
+            it->second.tail = idx;
+        }
+        // a new entry is the youngest with the lowest count
+        if (!max_dirty_ && max_idx_ == -1) {
+            max_idx_ = idx;
+        }
+    }
+
+    // one more ACT to rowid, counted on its oldest entry
+    void Bump(uint32_t rowid) {
+        if (size_ == 0) {
+            return;
+        }
+        auto it = rows_.find(rowid);
+        if (it == rows_.end()) {
+            return;
+        }
+        int idx = it->second.head;
+        Entry& entry = entries_[idx];
+        entry.ctr++;
+        if (max_dirty_) {
+            return;
+        }
+        if (entry.ctr == 0) {  // wrapped around
+            max_dirty_ = true;
+        } else if (IsBefore(entry, entries_[max_idx_])) {
+            max_idx_ = idx;
+        }
+    }
+
+    // highest count in the sampler, 0 when empty
+    uint16_t MaxCount() const {
+        int idx = MaxIndex();
+        return idx == -1 ? 0 : entries_[idx].ctr;
+    }
+
+    // removes the oldest entry with the highest count, returns its row or -1
+    int64_t PopMax() {
+        int idx = MaxIndex();
+        if (idx == -1) {
+            return -1;
+        }
+        Entry& entry = entries_[idx];
+        auto it = rows_.find(entry.rowid);
+        // only the oldest entry of a row can count above 0, and the oldest
+        // entry overall is the oldest of its row, so this is always a head
+        assert(it != rows_.end() && it->second.head == idx);
+        if (entry.next == -1) {
+            rows_.erase(it);
+        } else {
+            it->second.head = entry.next;
+        }
+        entry.live = false;
+        free_.push_back(idx);
+        size_--;
+        max_dirty_ = true;
+        return entry.rowid;
+    }
+
+    void Checkpoint(StateIO& io) {
+        io(entries_, free_, rows_, max_idx_, max_dirty_, next_seq_, size_);
+    }
+
+   private:
+    struct Entry {
+        uint32_t rowid;
+        uint16_t ctr;
+        bool live;
+        int next;  // next (younger) entry of the same row, -1 if none
+        uint64_t seq;
+    };
+    struct RowList {
+        int head;  // oldest entry
+        int tail;  // youngest entry
+    };
+
+    static bool IsBefore(const Entry& a, const Entry& b) {
+        return a.ctr > b.ctr || (a.ctr == b.ctr && a.seq < b.seq);
+    }
+
+    // the maximum is only rescanned after the entry holding it is removed,
+    // which happens once per DRFM against a counter bump on every ACT
+    int MaxIndex() const {
+        if (max_dirty_) {
+            max_idx_ = -1;
+            for (size_t i = 0; i < entries_.size(); i++) {
+                if (entries_[i].live &&
+                    (max_idx_ == -1 || IsBefore(entries_[i], entries_[max_idx_]))) {
+                    max_idx_ = static_cast<int>(i);
+                }
+            }
+            max_dirty_ = false;
+        }
+        return max_idx_;
+    }
+
+    std::vector<Entry> entries_;
+    std::vector<int> free_;
+    std::unordered_map<uint32_t, RowList> rows_;
+    mutable int max_idx_;
+    mutable bool max_dirty_;
+    uint64_t next_seq_;
+    size_t size_;
+};
+
+}  // namespace dramsim3
+#endif
@@ -0,0 +1,222 @@
+#ifndef __GRAPHENE_TRACKER_H
+#define __GRAPHENE_TRACKER_H
+
+#include <cstddef>
+#include <set>
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "state_io.h"
+
+namespace dramsim3 {
+
+// [GRAPHENE] Misra-Gries / Space-Saving table of per row ACT counts.
+// Entries hang off a doubly linked list of count buckets sorted by count, so
+// bumping a row moves it to the neighbouring bucket and the spill candidate
+// and the maximum are bucket lookups. Every entry keeps the slot it got in
+// the table (replacing a row keeps the slot), and ties are broken by that
+// slot order the same way a scan of the table would.
+class GrapheneTracker {
+   public:
+    GrapheneTracker() : GrapheneTracker(0, 1) {}
+    GrapheneTracker(size_t num_entries, uint32_t threshold)
+        : num_entries_(num_entries),
+          threshold_(threshold),
+          spill_counter_(0),
+          head_(-1),
+          tail_(-1),
+          next_order_(0) {
+        entries_.reserve(num_entries);
+        rows_.reserve(num_entries);
+    }
+
+    uint64_t SpillCounter() const { return spill_counter_; }
+
+    // counts an ACT to rowid, returns false if the table spilled instead
+    bool Access(uint32_t rowid) {
+        auto it = rows_.find(rowid);
+        if (it != rows_.end()) {
+            Increment(it->second);
+            return true;
+        }
+        if (rows_.size() < num_entries_) {
+            AddEntry(rowid);
+            return true;
+        }
+        // replace the first entry sitting at the spill counter
+        auto bucket = bucket_of_count_.find(spill_counter_);
+        if (bucket == bucket_of_count_.end()) {
+            spill_counter_++;
+            return false;
+        }
+        int idx = buckets_[bucket->second].members.begin()->second;
+        Entry& entry = entries_[idx];
+        rows_.erase(entry.rowid);
+        entry.rowid = rowid;
+        rows_.emplace(rowid, idx);
+        Increment(idx);
+        return true;
+    }
+
+    // row of the first entry at or above the threshold, -1 if none
+    int64_t FirstAboveThreshold() const {
+        if (above_th_.empty()) {
+            return -1;
+        }
+        return entries_[above_th_.begin()->second].rowid;
+    }
+
+    // removes the first entry with the highest count, returns its row or -1
+    int64_t PopMax() {
+        if (tail_ == -1) {
+            return -1;
+        }
+        int idx = buckets_[tail_].members.begin()->second;
+        Entry& entry = entries_[idx];
+        int64_t rowid = entry.rowid;
+        RemoveFromBucket(idx);
+        above_th_.erase(KeyOf(idx));
+        rows_.erase(entry.rowid);
+        free_entries_.push_back(idx);
+        return rowid;
+    }
+
+    void Clear() {
+        entries_.clear();
+        free_entries_.clear();
+        rows_.clear();
+        buckets_.clear();
+        free_buckets_.clear();
+        bucket_of_count_.clear();
+        above_th_.clear();
+        spill_counter_ = 0;
+        head_ = tail_ = -1;
+        next_order_ = 0;
+    }
+
+    void Checkpoint(StateIO& io) {
+        io(spill_counter_, entries_, free_entries_, rows_, buckets_,
+           free_buckets_, bucket_of_count_, head_, tail_, above_th_,
+           next_order_);
+    }
+
+   private:
+    // (slot order, entry index), ordered the way the table is scanned
+    using Key = std::pair<uint64_t, int>;
+
+    struct Entry {
+        uint32_t rowid;
+        uint64_t count;
+        uint64_t order;
+        int bucket;
+    };
+    struct Bucket {
+        uint64_t count;
+        int prev, next;  // buckets with lower/higher counts
+        std::set<Key> members;
+
+        void Checkpoint(StateIO& io) { io(count, prev, next, members); }
+    };
+
+    Key KeyOf(int idx) const { return Key(entries_[idx].order, idx); }
+
+    void AddEntry(uint32_t rowid) {
+        int idx;
+        if (free_entries_.empty()) {
+            idx = static_cast<int>(entries_.size());
+            entries_.emplace_back();
+        } else {
+            idx = free_entries_.back();
+            free_entries_.pop_back();
+        }
+        Entry& entry = entries_[idx];
+        entry.rowid = rowid;
+        entry.count = 1;
+        entry.order = next_order_++;
+        rows_.emplace(rowid, idx);
+
+        // counts never drop below 1, so this is the lowest bucket
+        int bucket = head_;
+        if (bucket == -1 || buckets_[bucket].count != 1) {
+            bucket = NewBucket(1, -1, head_);
+        }
+        AddToBucket(idx, bucket);
+        if (entry.count >= threshold_) {
+            above_th_.insert(KeyOf(idx));
+        }
+    }
+
+    void Increment(int idx) {
+        Entry& entry = entries_[idx];
+        int from = entry.bucket;
+        entry.count++;
+        int to = buckets_[from].next;
+        if (to == -1 || buckets_[to].count != entry.count) {
+            to = NewBucket(entry.count, from, to);
+        }
+        RemoveFromBucket(idx);
+        AddToBucket(idx, to);
+        if (entry.count == threshold_) {
+            above_th_.insert(KeyOf(idx));
+        }
+    }
+
+    int NewBucket(uint64_t count, int prev, int next) {
+        int idx;
+        if (free_buckets_.empty()) {
+            idx = static_cast<int>(buckets_.size());
+            buckets_.emplace_back();
+        } else {
+            idx = free_buckets_.back();
+            free_buckets_.pop_back();
+        }
+        Bucket& bucket = buckets_[idx];
+        bucket.count = count;
+        bucket.prev = prev;
+        bucket.next = next;
+        (prev == -1 ? head_ : buckets_[prev].next) = idx;
+        (next == -1 ? tail_ : buckets_[next].prev) = idx;
+        bucket_of_count_.emplace(count, idx);
+        return idx;
+    }
+
+    void AddToBucket(int idx, int bucket) {
+        entries_[idx].bucket = bucket;
+        buckets_[bucket].members.insert(KeyOf(idx));
+    }
+
+    // drops the bucket once it is empty
+    void RemoveFromBucket(int idx) {
+        int b = entries_[idx].bucket;
+        Bucket& bucket = buckets_[b];
+        bucket.members.erase(KeyOf(idx));
+        if (!bucket.members.empty()) {
+            return;
+        }
+        (bucket.prev == -1 ? head_ : buckets_[bucket.prev].next) = bucket.next;
+        (bucket.next == -1 ? tail_ : buckets_[bucket.next].prev) = bucket.prev;
+        bucket_of_count_.erase(bucket.count);
+        free_buckets_.push_back(b);
+    }
+
+    size_t num_entries_;
+    uint64_t threshold_;
+    uint64_t spill_counter_;
+
+    std::vector<Entry> entries_;
+    std::vector<int> free_entries_;
+    std::unordered_map<uint32_t, int> rows_;
+
+    std::vector<Bucket> buckets_;
+    std::vector<int> free_buckets_;
+    std::unordered_map<uint64_t, int> bucket_of_count_;
+    int head_, tail_;  // lowest and highest count buckets
+
+    // entries with count >= threshold_
+    std::set<Key> above_th_;
+    uint64_t next_order_;
+};
+
+}  // namespace dramsim3
+#endif
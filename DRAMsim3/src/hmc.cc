@@ -302,6 +302,11 @@ HMCMemorySystem::~HMCMemorySystem() {
     }
 }
 
+void HMCMemorySystem::Checkpoint(StateIO &io) {
+    std::cerr << "Simulator state cannot be saved for HMC" << std::endl;
+    AbruptExit(__FILE__, __LINE__);
+}
+
 void HMCMemorySystem::SetClockRatio() {
     // There are 3 clock domains here, Link (super fast), logic (fast), DRAM
     // (slow) We assume the logic process 1 flit per logic cycle and since the
@@ -26,6 +26,22 @@ Config* MemorySystem::GetConfig() const { return config_; }
 
 void MemorySystem::ClockTick() { dram_system_->ClockTick(); }
 
+void MemorySystem::AdvanceTo(uint64_t clk) { dram_system_->AdvanceTo(clk); }
+
+void MemorySystem::StopWorkers() { dram_system_->StopWorkers(); }
+
+void MemorySystem::StartWorkers() { dram_system_->StartWorkers(); }
+
+void MemorySystem::SaveState(std::ostream &out) {
+    StateIO io(out);
+    dram_system_->Checkpoint(io);
+}
+
+void MemorySystem::LoadState(std::istream &in) {
+    StateIO io(in);
+    dram_system_->Checkpoint(io);
+}
+
 double MemorySystem::GetTCK() const { return config_->tCK; }
 
 int MemorySystem::GetBusBits() const { return config_->bus_width; }
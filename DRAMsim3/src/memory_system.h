@@ -2,6 +2,7 @@
 #define __MEMORY_SYSTEM__H
 
 #include <functional>
+#include <iostream>
 #include <string>
 
 #include "configuration.h"
@@ -18,6 +19,15 @@ class MemorySystem {
                  std::function<void(uint64_t)> write_callback);
     ~MemorySystem();
     void ClockTick();
+    // fast forward to cycle clk, same results as ticking there one by one
+    void AdvanceTo(uint64_t clk);
+    // stop the channel_threads helpers around a fork()
+    void StopWorkers();
+    void StartWorkers();
+    // warmed up state of the controllers, to be loaded into a memory system
+    // of the same config, between ticks only
+    void SaveState(std::ostream &out);
+    void LoadState(std::istream &in);
     void RegisterCallbacks(std::function<void(uint64_t)> read_callback,
                            std::function<void(uint64_t)> write_callback);
     double GetTCK() const;
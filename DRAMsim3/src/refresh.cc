@@ -1,5 +1,7 @@
 #include "refresh.h"
 
+#include <limits>
+
 namespace dramsim3 {
 Refresh::Refresh(const Config &config, ChannelState &channel_state)
     : clk_(0),
@@ -30,6 +32,17 @@ void Refresh::ClockTick() {
     return;
 }
 
+uint64_t Refresh::NextRefreshCycle() const {
+    if (refresh_policy_ == RefreshPolicy::NO_REFRESH) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    uint64_t interval = static_cast<uint64_t>(refresh_interval_);
+    if (clk_ == 0) {
+        return interval;
+    }
+    return (clk_ + interval - 1) / interval * interval;
+}
+
 void Refresh::InsertRefresh() {
     switch (refresh_policy_) {
         // Simultaneous all rank refresh
@@ -4,6 +4,7 @@
 #include "channel_state.h"
 #include "common.h"
 #include "configuration.h"
+#include "state_io.h"
 
 namespace dramsim3 {
 
@@ -11,6 +12,12 @@ class Refresh {
    public:
     Refresh(const Config& config, ChannelState& channel_state);
     void ClockTick();
+    // first cycle at or after clk_ on which a refresh gets inserted
+    uint64_t NextRefreshCycle() const;
+    void AdvanceTo(uint64_t clk) { clk_ = clk; }
+    void Checkpoint(StateIO& io) {
+        io(clk_, next_rank_, next_bg_, next_bank_);
+    }
 
    private:
     uint64_t clk_;
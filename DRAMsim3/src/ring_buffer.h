@@ -0,0 +1,73 @@
+#ifndef __RING_BUFFER_H
+#define __RING_BUFFER_H
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+#include "state_io.h"
+
+namespace dramsim3 {
+
+// FIFO over a power of two sized ring, doubling when full, so pops from the
+// front do not shift the remaining entries the way vector::erase(begin()) does
+template <typename T>
+class RingBuffer {
+   public:
+    explicit RingBuffer(size_t capacity = 16) : head_(0), size_(0) {
+        size_t cap = 1;
+        while (cap < capacity) {
+            cap <<= 1;
+        }
+        buf_.resize(cap);
+    }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    const T& front() const {
+        assert(size_ > 0);
+        return buf_[head_];
+    }
+
+    void push_back(const T& val) {
+        if (size_ == buf_.size()) {
+            Grow();
+        }
+        buf_[(head_ + size_) & (buf_.size() - 1)] = val;
+        size_++;
+    }
+
+    // pushes num copies of val
+    void push_back(const T& val, size_t num) {
+        for (size_t i = 0; i < num; i++) {
+            push_back(val);
+        }
+    }
+
+    void pop_front() {
+        assert(size_ > 0);
+        head_ = (head_ + 1) & (buf_.size() - 1);
+        size_--;
+    }
+
+    void clear() { head_ = size_ = 0; }
+
+    void Checkpoint(StateIO& io) { io(buf_, head_, size_); }
+
+   private:
+    void Grow() {
+        std::vector<T> buf(buf_.size() * 2);
+        for (size_t i = 0; i < size_; i++) {
+            buf[i] = buf_[(head_ + i) & (buf_.size() - 1)];
+        }
+        buf_.swap(buf);
+        head_ = 0;
+    }
+
+    std::vector<T> buf_;
+    size_t head_;
+    size_t size_;
+};
+
+}  // namespace dramsim3
+#endif
@@ -0,0 +1,54 @@
+#ifndef __RNG_H
+#define __RNG_H
+
+#include <stdint.h>
+
+namespace dramsim3 {
+
+// xoshiro256** generator, small and cheap enough to give every bank its own.
+// The state is filled by splitmix64 from (seed, stream), so the generators
+// seeded with the same seed and different streams are independent and a
+// bank draws the same numbers no matter what the other banks do.
+class Rng {
+   public:
+    explicit Rng(uint64_t seed = 0, uint64_t stream = 0) {
+        uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+        for (auto& s : s_) {
+            x += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = x;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            s = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t Next() {
+        uint64_t result = Rotl(s_[1] * 5, 7) * 9;
+        uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = Rotl(s_[3], 45);
+        return result;
+    }
+
+    // uniform in [0, bound), by multiply-shift rather than a modulo
+    uint32_t Below(uint32_t bound) {
+        return static_cast<uint32_t>(((Next() >> 32) * bound) >> 32);
+    }
+
+    // uniform in [0, 1)
+    double Uniform() { return (Next() >> 11) * (1.0 / (1ULL << 53)); }
+
+   private:
+    static uint64_t Rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t s_[4];
+};
+
+}  // namespace dramsim3
+#endif
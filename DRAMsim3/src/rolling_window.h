@@ -0,0 +1,41 @@
+#ifndef __ROLLING_WINDOW_H
+#define __ROLLING_WINDOW_H
+
+#include <stdint.h>
+#include <vector>
+#include "state_io.h"
+
+namespace dramsim3 {
+
+// "At most N events in any window of W cycles" constraints (tFAW, t32AW).
+// Keeps the expiry time (event time + W) of the last N events in a fixed
+// ring, so the oldest of them is always the slot about to be overwritten.
+class RollingWindow {
+   public:
+    explicit RollingWindow(int num_events = 1, uint64_t window = 0)
+        : window_(window), expiry_(num_events, 0), next_(0), count_(0) {}
+
+    void Add(uint64_t clk) {
+        expiry_[next_] = clk + window_;
+        next_ = next_ + 1 == expiry_.size() ? 0 : next_ + 1;
+        if (count_ < expiry_.size()) {
+            count_++;
+        }
+    }
+
+    // whether one more event at clk keeps the window within N events
+    bool Ready(uint64_t clk) const {
+        return count_ < expiry_.size() || clk >= expiry_[next_];
+    }
+
+    void Checkpoint(StateIO& io) { io(expiry_, next_, count_); }
+
+   private:
+    uint64_t window_;
+    std::vector<uint64_t> expiry_;
+    size_t next_;
+    size_t count_;
+};
+
+}  // namespace dramsim3
+#endif
@@ -0,0 +1,118 @@
+#ifndef __ROW_COUNT_CACHE_H
+#define __ROW_COUNT_CACHE_H
+
+#include <stdint.h>
+#include <vector>
+#include "simple_stats.h"
+#include "state_io.h"
+
+namespace dramsim3 {
+
+// [HYDRA] Row Count Cache of a channel, set associative cache in front of
+// the row counters Hydra keeps in DRAM. Replacement is bit-PLRU: each way has
+// an MRU bit that is set on access (clearing the others once all would be
+// set), the victim is the first invalid way or else the first way with its
+// MRU bit clear, so lookup and victim selection are a few mask operations.
+class RowCountCache {
+   public:
+    static constexpr int kMaxWays = 64;
+
+    explicit RowCountCache(SimpleStats& simple_stats)
+        : simple_stats_(simple_stats), sets_(0), ways_(0), all_ways_(0) {}
+
+    // allocates sets x ways (ways <= kMaxWays) lines and registers the stats
+    void Init(int sets, int ways) {
+        sets_ = sets;
+        ways_ = ways;
+        all_ways_ = ways == kMaxWays ? ~0ULL : (1ULL << ways) - 1;
+        tags_.assign(static_cast<size_t>(sets) * ways, 0);
+        lines_.assign(sets, Set());
+        hits_stat_ = simple_stats_.InitCounter("hydra_rcc_hits", "Hydra RCC hits");
+        misses_stat_ = simple_stats_.InitCounter("hydra_rcc_misses", "Hydra RCC read misses");
+        reads_stat_ = simple_stats_.InitCounter("hydra_rcc_reads", "Hydra RCC reads");
+        writes_stat_ = simple_stats_.InitCounter("hydra_rcc_writes", "Hydra RCC writes");
+        writebacks_stat_ = simple_stats_.InitCounter("hydra_rcc_writebacks", "Hydra RCC writebacks");
+    }
+
+    // returns 0 on a hit, on a miss fills a clean line and returns the tag of
+    // the dirty line it evicted, or -1 if there was none
+    int64_t Read(uint64_t tag, uint64_t set_hint) {
+        simple_stats_.Increment(reads_stat_);
+        return Access(tag, set_hint, false);
+    }
+
+    // same as Read() but leaves the line dirty, write misses are not counted
+    int64_t Write(uint64_t tag, uint64_t set_hint) {
+        simple_stats_.Increment(writes_stat_);
+        return Access(tag, set_hint, true);
+    }
+
+    void Checkpoint(StateIO& io) { io(tags_, lines_); }
+
+   private:
+    struct Set {
+        Set() : valid(0), dirty(0), mru(0) {}
+        uint64_t valid;
+        uint64_t dirty;
+        uint64_t mru;
+    };
+
+    int64_t Access(uint64_t tag, uint64_t set_hint, bool is_write) {
+        size_t set = set_hint % sets_;
+        Set& line = lines_[set];
+        const uint64_t* tags = &tags_[set * ways_];
+        for (int i = 0; i < ways_; i++) {
+            uint64_t way = 1ULL << i;
+            if (tags[i] == tag && (line.valid & way)) {
+                if (is_write) {
+                    line.dirty |= way;
+                } else {
+                    simple_stats_.Increment(hits_stat_);
+                }
+                Touch(line, way);
+                return 0;
+            }
+        }
+        if (!is_write) {
+            simple_stats_.Increment(misses_stat_);
+        }
+
+        uint64_t free = ~line.valid & all_ways_;
+        uint64_t cold = free ? free : ~line.mru & all_ways_;
+        int victim = cold ? __builtin_ctzll(cold) : 0;  // 0 with a single way
+        uint64_t way = 1ULL << victim;
+        int64_t writeback_tag = -1;
+        if (line.valid & line.dirty & way) {
+            simple_stats_.Increment(writebacks_stat_);
+            writeback_tag = tags[victim];
+        }
+        tags_[set * ways_ + victim] = tag;
+        line.valid |= way;
+        line.dirty = is_write ? line.dirty | way : line.dirty & ~way;
+        Touch(line, way);
+        return writeback_tag;
+    }
+
+    void Touch(Set& line, uint64_t way) {
+        line.mru |= way;
+        if (line.mru == all_ways_) {
+            line.mru = way;
+        }
+    }
+
+    SimpleStats& simple_stats_;
+    int sets_;
+    int ways_;
+    uint64_t all_ways_;
+    std::vector<uint64_t> tags_;
+    std::vector<Set> lines_;
+
+    int hits_stat_;
+    int misses_stat_;
+    int reads_stat_;
+    int writes_stat_;
+    int writebacks_stat_;
+};
+
+}  // namespace dramsim3
+#endif
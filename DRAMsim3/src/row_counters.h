@@ -0,0 +1,139 @@
+#ifndef __ROW_COUNTERS_H
+#define __ROW_COUNTERS_H
+
+#include <algorithm>
+#include <limits>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "state_io.h"
+
+namespace dramsim3 {
+
+// Per row counters of a bank (PRAC, Hydra). Rows are grouped in pages that
+// are only allocated once one of their counters becomes non zero, and pages
+// are handed back when a reset leaves them all zero. Counters are 16 bits,
+// the few that grow past that keep their exact value in a side table.
+// Counters saturate at limit, which callers that only compare against a
+// threshold can set to the threshold to never need the side table.
+class RowCounters {
+   public:
+    explicit RowCounters(int num_rows = 0,
+                         uint32_t limit = std::numeric_limits<uint32_t>::max())
+        : num_rows_(num_rows),
+          limit_(limit),
+          pages_((num_rows + kPageRows - 1) / kPageRows) {}
+
+    uint32_t Get(int row) const {
+        const auto& page = pages_[row >> kPageBits];
+        if (page.empty()) {
+            return 0;
+        }
+        uint16_t val = page[row & (kPageRows - 1)];
+        return val == kWide ? wide_.at(row) : val;
+    }
+
+    void Increment(int row) {
+        uint16_t* page = GetPage(row);
+        uint16_t& val = page[row & (kPageRows - 1)];
+        if (val < kWide - 1 && val < limit_) {
+            val++;
+        } else {
+            uint32_t cur = Get(row);
+            if (cur < limit_) {
+                Set(row, cur + 1);
+            }
+        }
+    }
+
+    void Set(int row, uint32_t value) {
+        value = std::min(value, limit_);
+        if (value == 0 && pages_[row >> kPageBits].empty()) {
+            return;
+        }
+        uint16_t& val = GetPage(row)[row & (kPageRows - 1)];
+        if (value >= kWide) {
+            wide_[row] = value;
+            val = kWide;
+        } else {
+            if (val == kWide) {
+                wide_.erase(row);
+            }
+            val = static_cast<uint16_t>(value);
+        }
+    }
+
+    // zeroes rows [first, first + num), which must not wrap around, and hands
+    // over the values they held: runs of plain counters as a whole through
+    // values(const uint16_t* vals, int n), zero runs of unallocated pages and
+    // the rows kept in the side table through value(val, count)
+    template <typename F, typename G>
+    void ResetRows(int first, int num, F value, G values) {
+        int last = first + num;
+        while (first < last) {
+            int page_idx = first >> kPageBits;
+            int page_end = std::min((page_idx + 1) * kPageRows, num_rows_);
+            int end = std::min(last, page_end);
+            auto& page = pages_[page_idx];
+            if (page.empty()) {
+                value(0, static_cast<uint64_t>(end - first));
+            } else {
+                uint16_t* vals = page.data() + (first & (kPageRows - 1));
+                int n = end - first;
+                int run = 0;
+                for (int i = 0; i < n; i++) {
+                    if (vals[i] == kWide) {
+                        if (run < i) {
+                            values(vals + run, i - run);
+                        }
+                        value(wide_.at(first + i), 1);
+                        wide_.erase(first + i);
+                        run = i + 1;
+                    }
+                }
+                if (run < n) {
+                    values(vals + run, n - run);
+                }
+                std::fill(vals, vals + n, 0);
+                // refreshes walk the rows in order, so check once they
+                // reach the end of the page whether it can go
+                if (end == page_end &&
+                    std::all_of(page.begin(), page.end(),
+                                [](uint16_t v) { return v == 0; })) {
+                    std::vector<uint16_t>().swap(page);
+                }
+            }
+            first = end;
+        }
+    }
+
+    void Clear() {
+        for (auto& page : pages_) {
+            std::vector<uint16_t>().swap(page);
+        }
+        wide_.clear();
+    }
+
+    void Checkpoint(StateIO& io) { io(pages_, wide_); }
+
+   private:
+    static constexpr int kPageBits = 10;
+    static constexpr int kPageRows = 1 << kPageBits;
+    static constexpr uint16_t kWide = std::numeric_limits<uint16_t>::max();
+
+    uint16_t* GetPage(int row) {
+        auto& page = pages_[row >> kPageBits];
+        if (page.empty()) {
+            page.resize(kPageRows, 0);
+        }
+        return page.data();
+    }
+
+    int num_rows_;
+    uint32_t limit_;
+    std::vector<std::vector<uint16_t> > pages_;  // empty until touched
+    std::unordered_map<int, uint32_t> wide_;  // rows holding kWide
+};
+
+}  // namespace dramsim3
+#endif
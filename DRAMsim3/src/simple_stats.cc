@@ -89,13 +89,59 @@ SimpleStats::SimpleStats(const Config& config, int channel_id)
              "Average request interarrival latency (cycles)");
 }
 
+int SimpleStats::InitCounter(std::string name, std::string description) {
+    InitStat(name, "counter", description);
+    return GetStatId(name);
+}
+
+int SimpleStats::GetStatId(const std::string& name) const {
+    auto it = counter_ids_.find(name);
+    if (it == counter_ids_.end()) {
+        std::cerr << "Unregistered counter " << name << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    return it->second;
+}
+
+int SimpleStats::GetVecStatId(const std::string& name) const {
+    auto it = vec_counter_ids_.find(name);
+    if (it == vec_counter_ids_.end()) {
+        std::cerr << "Unregistered vec counter " << name << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    return it->second;
+}
+
+int SimpleStats::GetHistoStatId(const std::string& name) const {
+    auto it = histo_ids_.find(name);
+    if (it == histo_ids_.end()) {
+        std::cerr << "Unregistered histogram " << name << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    return it->second;
+}
+
 void SimpleStats::AddValue(const std::string name, const int value) {
-    auto& epoch_counts = epoch_histo_counts_[name];
-    if (epoch_counts.count(value) <= 0) {
-        epoch_counts[value] = 1;
-    } else {
-        epoch_counts[value] += 1;
+    epoch_histos_[GetHistoStatId(name)].Add(value);
+}
+
+void Histogram::Merge(const Histogram& other) {
+    // both sides come from the same InitHistoStat() so the dense ranges match
+    for (size_t i = 0; i < bins_.size(); i++) {
+        bins_[i] += other.bins_[i];
     }
+    for (const auto& it : other.overflow_) {
+        overflow_[it.first] += it.second;
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+}
+
+void Histogram::Clear() {
+    std::fill(bins_.begin(), bins_.end(), 0);
+    overflow_.clear();
+    count_ = 0;
+    sum_ = 0;
 }
 
 std::string SimpleStats::GetTextHeader(bool is_final) const {
@@ -161,14 +207,12 @@ void SimpleStats::PrintFinalStats(bool stdout) {
         }
     }
 
-    if (stdout) {
-        const_cast<LRUCache*>(&config_.hydra_rcc)->print_stats();
-    }
-
     print_pairs_.clear();
 }
 
 void SimpleStats::Reset() {
+    std::fill(epoch_counter_vals_.begin(), epoch_counter_vals_.end(), 0);
+    std::fill(epoch_vec_vals_.begin(), epoch_vec_vals_.end(), 0);
     for (auto& it : counters_) {
         it.second = 0;
     }
@@ -190,11 +234,32 @@ void SimpleStats::Reset() {
     for (auto& it : calculated_) {
         it.second = 0.0;
     }
-    for (auto& it : histo_counts_) {
-        it.second.clear();
+    for (auto& histo : histos_) {
+        histo.Clear();
+    }
+    for (auto& histo : epoch_histos_) {
+        histo.Clear();
     }
-    for (auto& it : epoch_histo_counts_) {
-        it.second.clear();
+}
+
+void SimpleStats::Checkpoint(StateIO& io) {
+    // the id based counts go to the named counters first, the slots point
+    // into the maps, so those load in place
+    FoldCounterIds();
+    io.InPlace(counters_);
+    io.InPlace(epoch_counters_);
+    io.InPlace(vec_counters_);
+    io.InPlace(epoch_vec_counters_);
+    io.InPlace(doubles_);
+    io.InPlace(vec_doubles_);
+    io.InPlace(calculated_);
+    io(histos_, epoch_histos_);
+    io.InPlace(histo_bins_);
+    io.InPlace(epoch_histo_bins_);
+    std::string j_data = j_data_.dump();
+    io(j_data, print_pairs_);
+    if (io.Loading()) {
+        j_data_ = Json::parse(j_data);
     }
 }
 
@@ -203,7 +268,12 @@ void SimpleStats::InitStat(std::string name, std::string stat_type,
     header_descs_.emplace(name, description);
     if (stat_type == "counter") {
         counters_.emplace(name, 0);
-        epoch_counters_.emplace(name, 0);
+        auto it = epoch_counters_.emplace(name, 0).first;
+        if (counter_ids_.count(name) == 0) {
+            counter_ids_.emplace(name, epoch_counter_vals_.size());
+            epoch_counter_vals_.push_back(0);
+            epoch_counter_slots_.push_back(&it->second);
+        }
     } else if (stat_type == "double") {
         doubles_.emplace(name, 0.0);
     } else if (stat_type == "calculated") {
@@ -222,7 +292,16 @@ void SimpleStats::InitVecStat(std::string name, std::string stat_type,
     }
     if (stat_type == "vec_counter") {
         vec_counters_.emplace(name, std::vector<uint64_t>(vec_len, 0));
-        epoch_vec_counters_.emplace(name, std::vector<uint64_t>(vec_len, 0));
+        auto it = epoch_vec_counters_
+                      .emplace(name, std::vector<uint64_t>(vec_len, 0))
+                      .first;
+        if (vec_counter_ids_.count(name) == 0) {
+            vec_counter_ids_.emplace(name, epoch_vec_vals_.size());
+            for (int i = 0; i < vec_len; i++) {
+                epoch_vec_vals_.push_back(0);
+                epoch_vec_slots_.push_back(&it->second[i]);
+            }
+        }
     } else if (stat_type == "vec_double") {
         vec_doubles_.emplace(name, std::vector<double>(vec_len, 0));
     }
@@ -230,11 +309,15 @@ void SimpleStats::InitVecStat(std::string name, std::string stat_type,
 
 void SimpleStats::InitHistoStat(std::string name, std::string description,
                                 int start_val, int end_val, int num_bins) {
+    if (histo_ids_.count(name) > 0) {
+        return;
+    }
     int bin_width = (end_val - start_val) / num_bins;
     bin_widths_.emplace(name, bin_width);
     histo_bounds_.emplace(name, std::make_pair(start_val, end_val));
-    histo_counts_.emplace(name, std::unordered_map<int, uint64_t>());
-    epoch_histo_counts_.emplace(name, std::unordered_map<int, uint64_t>());
+    histo_ids_.emplace(name, histos_.size());
+    histos_.emplace_back(start_val, end_val);
+    epoch_histos_.emplace_back(start_val, end_val);
 
     // initialize headers, descriptions
     std::vector<std::string> headers;
@@ -259,7 +342,19 @@ void SimpleStats::InitHistoStat(std::string name, std::string description,
     epoch_histo_bins_.emplace(name, std::vector<uint64_t>(num_bins + 2, 0));
 }
 
+void SimpleStats::FoldCounterIds() {
+    for (size_t i = 0; i < epoch_counter_vals_.size(); i++) {
+        *epoch_counter_slots_[i] += epoch_counter_vals_[i];
+        epoch_counter_vals_[i] = 0;
+    }
+    for (size_t i = 0; i < epoch_vec_vals_.size(); i++) {
+        *epoch_vec_slots_[i] += epoch_vec_vals_[i];
+        epoch_vec_vals_[i] = 0;
+    }
+}
+
 void SimpleStats::UpdateCounters() {
+    FoldCounterIds();
     for (const auto& it : epoch_counters_) {
         counters_[it.first] += it.second;
     }
@@ -274,54 +369,31 @@ void SimpleStats::UpdateHistoBins() {
     for (auto& name_bins : epoch_histo_bins_) {
         const auto& name = name_bins.first;
         auto& bins = name_bins.second;
+        const auto& bounds = histo_bounds_[name];
+        int bin_width = bin_widths_[name];
+        int id = histo_ids_[name];
         std::fill(bins.begin(), bins.end(), 0);
-        for (const auto it : epoch_histo_counts_[name]) {
-            int value = it.first;
-            uint64_t count = it.second;
+        epoch_histos_[id].ForEach([&](int value, uint64_t count) {
             int bin_idx = 0;
-            if (value < histo_bounds_[name].first) {
+            if (value < bounds.first) {
                 bin_idx = 0;
-            } else if (value > histo_bounds_[name].second) {
+            } else if (value > bounds.second) {
                 bin_idx = bins.size() - 1;
             } else {
-                bin_idx =
-                    (value - histo_bounds_[name].first) / bin_widths_[name] + 1;
+                bin_idx = (value - bounds.first) / bin_width + 1;
             }
             bins[bin_idx] += count;
-        }
-    }
+        });
 
-    // update overall histogram counts based on epoch histo counts
-    for (auto& name_counts : epoch_histo_counts_) {
-        const auto& name = name_counts.first;
-        auto& epoch_counts = name_counts.second;
-        auto& final_counts = histo_counts_[name];
-        for (const auto& val_cnt : epoch_counts) {
-            if (final_counts.count(val_cnt.first) <= 0) {
-                final_counts[val_cnt.first] = val_cnt.second;
-            } else {
-                final_counts[val_cnt.first] += val_cnt.second;
-            }
-        }
+        // update overall histogram counts based on epoch histo counts
+        histos_[id].Merge(epoch_histos_[id]);
         auto& final_bins = histo_bins_[name];
         for (size_t i = 0; i < final_bins.size(); i++) {
-            final_bins[i] += epoch_histo_bins_[name][i];
+            final_bins[i] += bins[i];
         }
     }
 }
 
-double SimpleStats::GetHistoAvg(const HistoCount& hist_counts) const {
-    uint64_t accu_sum = 0;
-    uint64_t count = 0;
-    for (auto i = hist_counts.begin(); i != hist_counts.end(); i++) {
-        accu_sum += i->first * i->second;
-        count += i->second;
-    }
-    return count == 0
-               ? 0.0
-               : static_cast<double>(accu_sum) / static_cast<double>(count);
-}
-
 void SimpleStats::UpdatePrints(bool epoch) {
     j_data_["channel"] = channel_id_;
 
@@ -356,12 +428,12 @@ void SimpleStats::UpdatePrints(bool epoch) {
     // huge therefore we only put aggregated histo in each epoch but
     // complete data at the end
     if (!epoch) {
-        for (const auto& name_hist : histo_counts_) {
+        for (const auto& name_id : histo_ids_) {
             Json j_list;
-            for (const auto& it : name_hist.second) {
-                j_list[std::to_string(it.first)] = it.second;
-            }
-            j_data_[name_hist.first] = j_list;
+            histos_[name_id.second].ForEach([&](int value, uint64_t count) {
+                j_list[std::to_string(value)] = count;
+            });
+            j_data_[name_id.first] = j_list;
         }
     }
 
@@ -433,9 +505,9 @@ void SimpleStats::UpdateEpochStats() {
     calculated_["total_energy"] = total_energy;
     calculated_["average_power"] = total_energy / epoch_counters_["num_cycles"];
     calculated_["average_read_latency"] =
-        GetHistoAvg(epoch_histo_counts_.at("read_latency"));
+        epoch_histos_[histo_ids_.at("read_latency")].Mean();
     calculated_["average_interarrival"] =
-        GetHistoAvg(epoch_histo_counts_.at("interarrival_latency"));
+        epoch_histos_[histo_ids_.at("interarrival_latency")].Mean();
 
     UpdatePrints(true);
     for (auto& it : epoch_counters_) {
@@ -444,8 +516,8 @@ void SimpleStats::UpdateEpochStats() {
     for (auto& vec : epoch_vec_counters_) {
         std::fill(vec.second.begin(), vec.second.end(), 0);
     }
-    for (auto& it : epoch_histo_counts_) {
-        it.second.clear();
+    for (auto& histo : epoch_histos_) {
+        histo.Clear();
     }
     return;
 }
@@ -495,9 +567,9 @@ void SimpleStats::UpdateFinalStats() {
     calculated_["average_power"] = total_energy / counters_["num_cycles"];
     // calculated_["average_read_latency"] = GetHistoAvg("read_latency");
     calculated_["average_read_latency"] =
-        GetHistoAvg(histo_counts_.at("read_latency"));
+        histos_[histo_ids_.at("read_latency")].Mean();
     calculated_["average_interarrival"] =
-        GetHistoAvg(histo_counts_.at("interarrival_latency"));
+        histos_[histo_ids_.at("interarrival_latency")].Mean();
 
     UpdatePrints(false);
     return;
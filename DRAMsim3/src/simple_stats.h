@@ -2,26 +2,108 @@
 #define __SIMPLE_STATS_
 
 #include <fstream>
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "configuration.h"
 #include "json.hpp"
+#include "state_io.h"
 
 namespace dramsim3 {
 
+// Histogram of int samples, values in [lo, hi] are counted in dense bins and
+// the rare ones outside of it in an overflow bucket that keeps the exact
+// values, count and sum are exact so the mean does not depend on binning
+class Histogram {
+   public:
+    Histogram() : lo_(0), count_(0), sum_(0) {}
+    Histogram(int lo, int hi)
+        : lo_(lo), bins_(hi - lo + 1, 0), count_(0), sum_(0) {}
+
+    void Add(int value, uint64_t num = 1) {
+        uint64_t idx = static_cast<uint64_t>(static_cast<int64_t>(value) - lo_);
+        if (idx < bins_.size()) {
+            bins_[idx] += num;
+        } else {
+            overflow_[value] += num;
+        }
+        count_ += num;
+        sum_ += static_cast<int64_t>(value) * static_cast<int64_t>(num);
+    }
+
+    // adds one sample for each of values[0, num), count and sum are updated
+    // once for the whole run
+    template <typename T>
+    void AddValues(const T* values, size_t num) {
+        int64_t sum = 0;
+        for (size_t i = 0; i < num; i++) {
+            int value = static_cast<int>(values[i]);
+            uint64_t idx =
+                static_cast<uint64_t>(static_cast<int64_t>(value) - lo_);
+            if (idx < bins_.size()) {
+                bins_[idx]++;
+            } else {
+                overflow_[value]++;
+            }
+            sum += value;
+        }
+        count_ += num;
+        sum_ += sum;
+    }
+
+    void Merge(const Histogram& other);
+    void Clear();
+    void Checkpoint(StateIO& io) { io(bins_, overflow_, count_, sum_); }
+    uint64_t Count() const { return count_; }
+    double Mean() const {
+        return count_ == 0 ? 0.0
+                           : static_cast<double>(sum_) /
+                                 static_cast<double>(count_);
+    }
+
+    // calls f(value, count) for every value seen at least once
+    template <typename F>
+    void ForEach(F f) const {
+        for (size_t i = 0; i < bins_.size(); i++) {
+            if (bins_[i] != 0) {
+                f(lo_ + static_cast<int>(i), bins_[i]);
+            }
+        }
+        for (const auto& it : overflow_) {
+            f(it.first, it.second);
+        }
+    }
+
+   private:
+    int lo_;
+    std::vector<uint64_t> bins_;
+    std::map<int, uint64_t> overflow_;
+    uint64_t count_;
+    int64_t sum_;
+};
+
 class SimpleStats {
    public:
     SimpleStats(const Config& config, int channel_id);
     // incrementing counter
     void Increment(const std::string name) { epoch_counters_[name] += 1; }
     void Increment(const std::string name, uint64_t val) { epoch_counters_[name] += val; }
-    void Assign(const std::string name, uint64_t val) { epoch_counters_[name] = val; }
+    void Assign(const std::string name, uint64_t val) {
+        FoldCounterIds();
+        epoch_counters_[name] = val;
+    }
     void AssignDbl(const std::string name, double val) { doubles_[name] = val; }
 
-    uint64_t GetCtr(const std::string name) { return counters_[name]; }
-    uint64_t GetECtr(const std::string name) { return epoch_counters_[name]; }
+    uint64_t GetCtr(const std::string name) {
+        FoldCounterIds();
+        return counters_[name];
+    }
+    uint64_t GetECtr(const std::string name) {
+        FoldCounterIds();
+        return epoch_counters_[name];
+    }
 
     // incrementing for vec counter
     void IncrementVec(const std::string name, int pos) {
@@ -29,13 +111,36 @@ class SimpleStats {
     }
 
     // increment vec counter by number
-    void IncrementVecBy(const std::string name, int pos, int num) {
+    void IncrementVecBy(const std::string name, int pos, uint64_t num) {
         epoch_vec_counters_[name][pos] += num;
     }
 
+    // hot path counters: look up the id of a registered (vec) counter once
+    // and increment through it, the values land in flat arrays and are folded
+    // back into the named counters before they are read or printed
+    int InitCounter(std::string name, std::string description);
+    int GetStatId(const std::string& name) const;
+    int GetVecStatId(const std::string& name) const;
+    void Increment(int id) { epoch_counter_vals_[id] += 1; }
+    void Increment(int id, uint64_t val) { epoch_counter_vals_[id] += val; }
+    void IncrementVec(int id, int pos) { epoch_vec_vals_[id + pos] += 1; }
+    void IncrementVecBy(int id, int pos, uint64_t num) {
+        epoch_vec_vals_[id + pos] += num;
+    }
+
     // add historgram value
     void AddValue(const std::string name, const int value);
 
+    // same through a histogram id, AddValues() adds num samples at once
+    int GetHistoStatId(const std::string& name) const;
+    void AddValue(int id, const int value, uint64_t num = 1) {
+        epoch_histos_[id].Add(value, num);
+    }
+    template <typename T>
+    void AddValues(int id, const T* values, size_t num) {
+        epoch_histos_[id].AddValues(values, num);
+    }
+
     // return per rank background energy
     double RankBackgroundEnergy(const int r) const;
 
@@ -48,8 +153,9 @@ class SimpleStats {
     // Reset (usually after one phase of simulation)
     void Reset();
 
+    void Checkpoint(StateIO& io);
+
     using VecStat = std::unordered_map<std::string, std::vector<uint64_t> >;
-    using HistoCount = std::unordered_map<int, uint64_t>;
     using Json = nlohmann::json;
     void InitStat(std::string name, std::string stat_type,
                   std::string description);
@@ -59,10 +165,10 @@ class SimpleStats {
     void InitHistoStat(std::string name, std::string description, int start_val,
                        int end_val, int num_bins);
    private:
+    void FoldCounterIds();
     void UpdateCounters();
     void UpdateHistoBins();
     void UpdatePrints(bool epoch);
-    double GetHistoAvg(const HistoCount& histo_counts) const;
     std::string GetTextHeader(bool is_final) const;
     void UpdateEpochStats();
     void UpdateFinalStats();
@@ -81,6 +187,17 @@ class SimpleStats {
     VecStat vec_counters_;
     VecStat epoch_vec_counters_;
 
+    // id based epoch counts, epoch_counter_slots_[id] points at the named
+    // counter a value is folded into (map nodes never move)
+    std::unordered_map<std::string, int> counter_ids_;
+    std::vector<uint64_t> epoch_counter_vals_;
+    std::vector<uint64_t*> epoch_counter_slots_;
+
+    // a vec counter id is the offset of its first element in epoch_vec_vals_
+    std::unordered_map<std::string, int> vec_counter_ids_;
+    std::vector<uint64_t> epoch_vec_vals_;
+    std::vector<uint64_t*> epoch_vec_slots_;
+
     // NOTE: doubles_ vec_doubles_ and calculated_ are basically one time
     // placeholders after each epoch they store the value for that epoch
     // (different from the counters) and in the end updated to the overall value
@@ -96,8 +213,9 @@ class SimpleStats {
 
     std::unordered_map<std::string, std::pair<int, int> > histo_bounds_;
     std::unordered_map<std::string, int> bin_widths_;
-    std::unordered_map<std::string, HistoCount> histo_counts_;
-    std::unordered_map<std::string, HistoCount> epoch_histo_counts_;
+    std::unordered_map<std::string, int> histo_ids_;
+    std::vector<Histogram> histos_;
+    std::vector<Histogram> epoch_histos_;
     VecStat histo_bins_;
     VecStat epoch_histo_bins_;
 
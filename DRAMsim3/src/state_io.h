@@ -0,0 +1,241 @@
+#ifndef __STATE_IO_H
+#define __STATE_IO_H
+
+#include <stdint.h>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "common.h"
+
+namespace dramsim3 {
+
+// Saves the simulator state to, or loads it from, a binary stream. Every
+// class holding state has a Checkpoint(StateIO& io) member that hands its
+// mutable members to io(...) in a fixed order, so the same code writes them
+// and reads them back. What the config fixes (sizes, stat ids, timing
+// tables, pointers) is not saved, a state only loads into a memory system
+// built from the config that saved it.
+class StateIO {
+   public:
+    explicit StateIO(std::ostream& out) : out_(&out), in_(nullptr) {}
+    explicit StateIO(std::istream& in) : out_(nullptr), in_(&in) {}
+
+    bool Loading() const { return in_ != nullptr; }
+
+    void operator()() {}
+    template <typename T, typename... Rest>
+    void operator()(T& val, Rest&... rest) {
+        Io(val);
+        (*this)(rest...);
+    }
+
+    // a value the loading side knows as well (format, geometry), a state
+    // that does not agree is not loaded
+    template <typename T>
+    void Check(const T& expected, const char* what) {
+        T val = expected;
+        Io(val);
+        if (Loading() && !(val == expected)) {
+            std::cerr << "Saved simulator state does not match: " << what
+                      << " is " << val << ", expected " << expected
+                      << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+    }
+
+    // for maps others hold pointers into: loads into the existing entries,
+    // which the loading side has registered the same way
+    template <typename Map>
+    void InPlace(Map& map) {
+        uint64_t size = map.size();
+        Io(size);
+        if (Loading()) {
+            for (uint64_t i = 0; i < size; i++) {
+                typename Map::key_type key;
+                Io(key);
+                Io(map[key]);
+            }
+        } else {
+            for (auto& it : map) {
+                typename Map::key_type key = it.first;
+                Io(key);
+                Io(it.second);
+            }
+        }
+    }
+
+    // a class with a Checkpoint() member or else a plain value
+    template <typename T>
+    void Io(T& val) {
+        IoValue(val, 0);
+    }
+
+    void Io(std::string& str) {
+        uint64_t size = str.size();
+        Io(size);
+        if (Loading()) {
+            str.resize(size);
+        }
+        Bytes(&str[0], size);
+    }
+
+    void Io(std::vector<bool>& vec) {
+        uint64_t size = vec.size();
+        Io(size);
+        if (Loading()) {
+            vec.resize(size);
+        }
+        for (size_t i = 0; i < vec.size(); i++) {
+            bool val = vec[i];
+            Io(val);
+            vec[i] = val;
+        }
+    }
+
+    template <typename T>
+    void Io(std::vector<T>& vec) {
+        uint64_t size = vec.size();
+        Io(size);
+        if (Loading()) {
+            vec.resize(size);
+        }
+        IoElements(vec, std::is_trivially_copyable<T>());
+    }
+
+    template <typename A, typename B>
+    void Io(std::pair<A, B>& pair) {
+        Io(pair.first);
+        Io(pair.second);
+    }
+
+    template <typename K, typename V, typename... Args>
+    void Io(std::map<K, V, Args...>& map) {
+        IoMap(map);
+    }
+
+    template <typename K, typename V, typename... Args>
+    void Io(std::unordered_map<K, V, Args...>& map) {
+        IoMap(map);
+    }
+
+    template <typename K, typename... Args>
+    void Io(std::set<K, Args...>& set) {
+        IoSet(set);
+    }
+
+    template <typename K, typename... Args>
+    void Io(std::unordered_set<K, Args...>& set) {
+        IoSet(set);
+    }
+
+    // common.h types have copy constructors of their own, so they are not
+    // trivially copyable and go field by field
+    void Io(Address& addr) {
+        (*this)(addr.channel, addr.rank, addr.bankgroup, addr.bank, addr.row,
+                addr.column);
+    }
+
+    void Io(Command& cmd) { (*this)(cmd.cmd_type, cmd.addr, cmd.hex_addr); }
+
+    void Io(Transaction& trans) {
+        (*this)(trans.addr, trans.added_cycle, trans.complete_cycle,
+                trans.is_write, trans.decoded_addr);
+    }
+
+   private:
+    // the int overload wins where both apply
+    template <typename T>
+    auto IoValue(T& obj, int) -> decltype(obj.Checkpoint(*this), void()) {
+        obj.Checkpoint(*this);
+    }
+
+    // ints, enums and structs of them
+    template <typename T>
+    void IoValue(T& val, long) {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "state needs a Checkpoint() member or plain bytes");
+        Bytes(&val, sizeof(T));
+    }
+
+    void Bytes(void* data, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        if (Loading()) {
+            in_->read(static_cast<char*>(data), size);
+            if (!*in_) {
+                std::cerr << "Truncated simulator state" << std::endl;
+                AbruptExit(__FILE__, __LINE__);
+            }
+        } else {
+            out_->write(static_cast<const char*>(data), size);
+        }
+    }
+
+    template <typename T>
+    void IoElements(std::vector<T>& vec, std::true_type) {
+        Bytes(vec.data(), vec.size() * sizeof(T));
+    }
+
+    template <typename T>
+    void IoElements(std::vector<T>& vec, std::false_type) {
+        for (auto& val : vec) {
+            Io(val);
+        }
+    }
+
+    // sets and maps are rebuilt on load, nothing depends on the order in
+    // which the unordered ones are walked
+    template <typename Map>
+    void IoMap(Map& map) {
+        uint64_t size = map.size();
+        Io(size);
+        if (Loading()) {
+            map.clear();
+            for (uint64_t i = 0; i < size; i++) {
+                typename Map::key_type key;
+                typename Map::mapped_type val;
+                Io(key);
+                Io(val);
+                map.emplace(std::move(key), std::move(val));
+            }
+        } else {
+            for (auto& it : map) {
+                typename Map::key_type key = it.first;
+                Io(key);
+                Io(it.second);
+            }
+        }
+    }
+
+    template <typename Set>
+    void IoSet(Set& set) {
+        uint64_t size = set.size();
+        Io(size);
+        if (Loading()) {
+            set.clear();
+            for (uint64_t i = 0; i < size; i++) {
+                typename Set::key_type key;
+                Io(key);
+                set.insert(std::move(key));
+            }
+        } else {
+            for (const auto& it : set) {
+                typename Set::key_type key = it;
+                Io(key);
+            }
+        }
+    }
+
+    std::ostream* out_;
+    std::istream* in_;
+};
+
+}  // namespace dramsim3
+#endif
@@ -4,14 +4,19 @@
 
 namespace dramsim3 {
 
-Timing::Timing(const Config& config)
-    : same_bank(static_cast<int>(CommandType::SIZE)),
-      other_banks_same_bankgroup(static_cast<int>(CommandType::SIZE)),
-      other_bankgroups_same_rank(static_cast<int>(CommandType::SIZE)),
-      other_ranks(static_cast<int>(CommandType::SIZE)),
-      same_rank(static_cast<int>(CommandType::SIZE)),
-      same_bankset(static_cast<int>(CommandType::SIZE)),
-      other_banksets(static_cast<int>(CommandType::SIZE)) {
+TimingList& TimingList::operator=(
+    const std::vector<std::pair<CommandType, int> >& list) {
+    if (list.size() > static_cast<size_t>(kCapacity)) {
+        std::cerr << "Timing list with " << list.size()
+                  << " entries exceeds capacity " << kCapacity << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    std::copy(list.begin(), list.end(), entries_.begin());
+    size_ = static_cast<int>(list.size());
+    return *this;
+}
+
+Timing::Timing(const Config& config) {
     int read_to_read_l = std::max(config.burst_cycle, config.tCCD_L);
     int read_to_read_s = std::max(config.burst_cycle, config.tCCD_S);
     int read_to_read_o = config.burst_cycle + config.tRTRS;
@@ -1,24 +1,46 @@
 #ifndef __TIMING_H
 #define __TIMING_H
 
+#include <array>
 #include <vector>
 #include "common.h"
 #include "configuration.h"
 
 namespace dramsim3 {
 
+// (command, delay) constraints a command puts on one group of banks, kept in
+// a fixed size array so a whole table is one flat block
+class TimingList {
+   public:
+    static constexpr int kCapacity = 16;
+
+    TimingList& operator=(const std::vector<std::pair<CommandType, int> >& list);
+
+    const std::pair<CommandType, int>* begin() const { return entries_.data(); }
+    const std::pair<CommandType, int>* end() const {
+        return entries_.data() + size_;
+    }
+    int size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+   private:
+    std::array<std::pair<CommandType, int>, kCapacity> entries_;
+    int size_ = 0;
+};
+
+using TimingTable =
+    std::array<TimingList, static_cast<int>(CommandType::SIZE)>;
+
 class Timing {
    public:
     Timing(const Config& config);
-    std::vector<std::vector<std::pair<CommandType, int> > > same_bank;
-    std::vector<std::vector<std::pair<CommandType, int> > >
-        other_banks_same_bankgroup;
-    std::vector<std::vector<std::pair<CommandType, int> > >
-        other_bankgroups_same_rank;
-    std::vector<std::vector<std::pair<CommandType, int> > > other_ranks;
-    std::vector<std::vector<std::pair<CommandType, int> > > same_rank;
-    std::vector<std::vector<std::pair<CommandType, int> > > same_bankset;
-    std::vector<std::vector<std::pair<CommandType, int> > > other_banksets;
+    TimingTable same_bank;
+    TimingTable other_banks_same_bankgroup;
+    TimingTable other_bankgroups_same_rank;
+    TimingTable other_ranks;
+    TimingTable same_rank;
+    TimingTable same_bankset;
+    TimingTable other_banksets;
 };
 
 }  // namespace dramsim3
@@ -0,0 +1,214 @@
+#ifndef __TRANS_TABLE_H
+#define __TRANS_TABLE_H
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+#include "common.h"
+#include "state_io.h"
+
+namespace dramsim3 {
+
+// Open addressing (linear probing) table of the transactions waiting on each
+// address. Transactions to an address that is already in the table are
+// merged into its slot, in arrival order.
+class TransTable {
+   public:
+    explicit TransTable(size_t expected_size) : size_(0) {
+        size_t capacity = 16;
+        while (capacity < expected_size * 2) {
+            capacity <<= 1;
+        }
+        slots_.resize(capacity);
+    }
+
+    // number of transactions waiting on addr
+    size_t Count(uint64_t addr) const {
+        const Slot* slot = Find(addr);
+        return slot == nullptr ? 0 : slot->count;
+    }
+
+    // first transaction waiting on addr, nullptr if none
+    const Transaction* Front(uint64_t addr) const {
+        const Slot* slot = Find(addr);
+        return slot == nullptr ? nullptr : &slot->first;
+    }
+
+    // returns the number of transactions waiting on trans.addr afterwards
+    size_t Insert(const Transaction& trans) {
+        if ((size_ + 1) * 2 > slots_.size()) {
+            Grow();
+        }
+        size_t idx = Probe(trans.addr);
+        Slot& slot = slots_[idx];
+        if (slot.count == 0) {
+            slot.first = trans;
+            size_++;
+        } else {
+            slot.more.push_back(trans);
+        }
+        slot.count++;
+        return slot.count;
+    }
+
+    // hands every transaction waiting on addr to f in arrival order and
+    // removes them, returns how many there were
+    template <typename F>
+    size_t Remove(uint64_t addr, F f) {
+        size_t idx = Probe(addr);
+        Slot& slot = slots_[idx];
+        size_t count = slot.count;
+        if (count == 0) {
+            return 0;
+        }
+        f(slot.first);
+        for (auto& trans : slot.more) {
+            f(trans);
+        }
+        slot.more.clear();
+        slot.count = 0;
+        size_--;
+        BackShift(idx);
+        return count;
+    }
+
+    size_t Remove(uint64_t addr) {
+        return Remove(addr, [](const Transaction&) {});
+    }
+
+    void Checkpoint(StateIO& io) { io(slots_, size_); }
+
+   private:
+    struct Slot {
+        Slot() : count(0) {}
+        uint32_t count;  // 0 for an empty slot
+        Transaction first;
+        std::vector<Transaction> more;
+
+        void Checkpoint(StateIO& io) { io(count, first, more); }
+    };
+
+    size_t Home(uint64_t addr) const {
+        // addresses are mostly line aligned, mix the low bits in
+        return (addr * 0x9E3779B97F4A7C15ull >> 32) & (slots_.size() - 1);
+    }
+
+    // slot holding addr, or the empty slot it would go into
+    size_t Probe(uint64_t addr) const {
+        size_t mask = slots_.size() - 1;
+        size_t idx = Home(addr);
+        while (slots_[idx].count != 0 && slots_[idx].first.addr != addr) {
+            idx = (idx + 1) & mask;
+        }
+        return idx;
+    }
+
+    const Slot* Find(uint64_t addr) const {
+        const Slot& slot = slots_[Probe(addr)];
+        return slot.count == 0 ? nullptr : &slot;
+    }
+
+    // close the hole left at idx so that probing never stops early
+    void BackShift(size_t hole) {
+        size_t mask = slots_.size() - 1;
+        size_t idx = (hole + 1) & mask;
+        while (slots_[idx].count != 0) {
+            size_t home = Home(slots_[idx].first.addr);
+            // move the entry if the hole lies cyclically in [home, idx)
+            if (((idx - home) & mask) >= ((idx - hole) & mask)) {
+                std::swap(slots_[hole], slots_[idx]);
+                hole = idx;
+            }
+            idx = (idx + 1) & mask;
+        }
+    }
+
+    void Grow() {
+        std::vector<Slot> old;
+        old.swap(slots_);
+        slots_.resize(old.size() * 2);
+        for (auto& slot : old) {
+            if (slot.count != 0) {
+                std::swap(slots_[Probe(slot.first.addr)], slot);
+            }
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t size_;
+};
+
+// Transactions waiting to be returned, bucketed by complete_cycle. Every
+// transaction is collected at its complete_cycle (AdvanceTo() never skips
+// past one), so handing out a bucket in insertion order keeps the order of
+// the flat return queue this replaces.
+class TransWheel {
+   public:
+    explicit TransWheel(uint64_t max_delay)
+        : next_cycle_(0), size_(0) {
+        size_t num_buckets = 4;
+        while (num_buckets < max_delay + 2) {
+            num_buckets <<= 1;
+        }
+        buckets_.resize(num_buckets);
+    }
+
+    bool Empty() const { return size_ == 0; }
+
+    void Push(const Transaction& trans) {
+        // complete_cycle is never behind what has been collected so far
+        uint64_t cycle = std::max(trans.complete_cycle, next_cycle_);
+        while (cycle - next_cycle_ >= buckets_.size()) {
+            Grow();
+        }
+        buckets_[cycle & (buckets_.size() - 1)].push_back(trans);
+        size_++;
+    }
+
+    // earliest complete_cycle in the wheel, Empty() must be false
+    uint64_t NextCycle() const {
+        assert(size_ > 0);
+        uint64_t cycle = next_cycle_;
+        while (buckets_[cycle & (buckets_.size() - 1)].empty()) {
+            cycle++;
+        }
+        return cycle;
+    }
+
+    // moves everything completing at or before clk to done
+    void Collect(uint64_t clk, std::vector<Transaction>& done) {
+        if (clk < next_cycle_) {
+            return;
+        }
+        uint64_t last = std::min(clk, next_cycle_ + buckets_.size() - 1);
+        for (uint64_t cycle = next_cycle_; cycle <= last && size_ > 0;
+             cycle++) {
+            auto& bucket = buckets_[cycle & (buckets_.size() - 1)];
+            done.insert(done.end(), bucket.begin(), bucket.end());
+            size_ -= bucket.size();
+            bucket.clear();
+        }
+        next_cycle_ = clk + 1;
+    }
+
+    void Checkpoint(StateIO& io) { io(buckets_, next_cycle_, size_); }
+
+   private:
+    void Grow() {
+        std::vector<std::vector<Transaction> > old;
+        old.swap(buckets_);
+        buckets_.resize(old.size() * 2);
+        for (uint64_t cycle = next_cycle_; cycle < next_cycle_ + old.size();
+             cycle++) {
+            buckets_[cycle & (buckets_.size() - 1)].swap(
+                old[cycle & (old.size() - 1)]);
+        }
+    }
+
+    std::vector<std::vector<Transaction> > buckets_;
+    uint64_t next_cycle_;
+    size_t size_;
+};
+
+}  // namespace dramsim3
+#endif
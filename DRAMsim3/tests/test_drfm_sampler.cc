@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "catch.hpp"
+#include "drfm_sampler.h"
+
+namespace {
+
+// the drfm_q_ vector DRFMSampler replaces
+struct RefEntry {
+    uint32_t rowid;
+    uint16_t ctr;
+};
+
+void RefBump(std::vector<RefEntry>& q, uint32_t rowid) {
+    auto found = std::find_if(q.begin(), q.end(), [rowid](const RefEntry& e) {
+        return e.rowid == rowid;
+    });
+    if (found != q.end()) {
+        found->ctr++;
+    }
+}
+
+std::vector<RefEntry>::iterator RefMax(std::vector<RefEntry>& q) {
+    return std::max_element(q.begin(), q.end(),
+                            [](const RefEntry& a, const RefEntry& b) {
+                                return a.ctr < b.ctr;
+                            });
+}
+
+}  // namespace
+
+TEST_CASE("DRFMSampler against the drfm_q_ vector", "[unit][drfm_sampler]") {
+    std::mt19937 gen(3);
+    // a handful of rows, so rows are queued more than once
+    std::uniform_int_distribution<uint32_t> row_dist(0, 15);
+    std::uniform_int_distribution<int> op_dist(0, 99);
+
+    dramsim3::DRFMSampler sampler(32);
+    std::vector<RefEntry> ref;
+
+    for (int i = 0; i < 200000; i++) {
+        int op = op_dist(gen);
+        uint32_t rowid = row_dist(gen);
+        if (op < 10 && ref.size() < 32) {
+            sampler.Insert(rowid);
+            ref.push_back({rowid, 0});
+        } else if (op < 15) {
+            auto max_entry = RefMax(ref);
+            int64_t expected = -1;
+            if (max_entry != ref.end()) {
+                expected = max_entry->rowid;
+                ref.erase(max_entry);
+            }
+            REQUIRE(sampler.PopMax() == expected);
+        } else {
+            sampler.Bump(rowid);
+            RefBump(ref, rowid);
+        }
+
+        REQUIRE(sampler.Size() == ref.size());
+        REQUIRE(sampler.Empty() == ref.empty());
+        auto max_entry = RefMax(ref);
+        REQUIRE(sampler.MaxCount() == (max_entry == ref.end() ? 0 : max_entry->ctr));
+    }
+
+    while (!ref.empty()) {
+        auto max_entry = RefMax(ref);
+        REQUIRE(sampler.PopMax() == max_entry->rowid);
+        ref.erase(max_entry);
+    }
+    REQUIRE(sampler.PopMax() == -1);
+}
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "catch.hpp"
+#include "graphene_tracker.h"
+
+namespace {
+
+// the graphene_q_ vector GrapheneTracker replaces
+struct RefEntry {
+    uint32_t rowid;
+    uint64_t ctr;
+};
+
+struct RefTracker {
+    size_t num_entries;
+    uint64_t threshold;
+    uint64_t spill_counter = 0;
+    std::vector<RefEntry> q;
+
+    bool Access(uint32_t rowid) {
+        auto found = std::find_if(q.begin(), q.end(), [rowid](const RefEntry& e) {
+            return e.rowid == rowid;
+        });
+        if (found != q.end()) {
+            found->ctr++;
+            return true;
+        }
+        if (q.size() < num_entries) {
+            q.push_back({rowid, 1});
+            return true;
+        }
+        auto low = std::find_if(q.begin(), q.end(), [this](const RefEntry& e) {
+            return e.ctr == spill_counter;
+        });
+        if (low == q.end()) {
+            spill_counter++;
+            return false;
+        }
+        low->rowid = rowid;
+        low->ctr = spill_counter + 1;
+        return true;
+    }
+
+    int64_t FirstAboveThreshold() const {
+        auto found = std::find_if(q.begin(), q.end(), [this](const RefEntry& e) {
+            return e.ctr >= threshold;
+        });
+        return found == q.end() ? -1 : static_cast<int64_t>(found->rowid);
+    }
+
+    int64_t PopMax() {
+        auto max_entry = std::max_element(q.begin(), q.end(),
+                                          [](const RefEntry& a, const RefEntry& b) {
+                                              return a.ctr < b.ctr;
+                                          });
+        if (max_entry == q.end()) {
+            return -1;
+        }
+        int64_t rowid = max_entry->rowid;
+        q.erase(max_entry);
+        return rowid;
+    }
+};
+
+}  // namespace
+
+TEST_CASE("GrapheneTracker against the graphene_q_ vector", "[unit][graphene_tracker]") {
+    const size_t kEntries = 16;
+    const uint32_t kThreshold = 40;
+    std::mt19937 gen(4);
+    // more rows than entries, skewed so that some rows cross the threshold
+    std::uniform_int_distribution<uint32_t> row_dist(0, 255);
+    std::uniform_int_distribution<uint32_t> hot_dist(0, 7);
+    std::uniform_int_distribution<int> op_dist(0, 999);
+
+    dramsim3::GrapheneTracker tracker(kEntries, kThreshold);
+    RefTracker ref{kEntries, kThreshold};
+
+    for (int i = 0; i < 300000; i++) {
+        int op = op_dist(gen);
+        if (op == 0) {
+            tracker.Clear();
+            ref.q.clear();
+            ref.spill_counter = 0;
+        } else if (op < 20) {
+            REQUIRE(tracker.PopMax() == ref.PopMax());
+        } else {
+            uint32_t rowid = op < 500 ? hot_dist(gen) : row_dist(gen);
+            REQUIRE(tracker.Access(rowid) == ref.Access(rowid));
+        }
+        REQUIRE(tracker.SpillCounter() == ref.spill_counter);
+        REQUIRE(tracker.FirstAboveThreshold() == ref.FirstAboveThreshold());
+    }
+}
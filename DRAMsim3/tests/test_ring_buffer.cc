@@ -0,0 +1,49 @@
+#include <random>
+#include <vector>
+#include "catch.hpp"
+#include "ring_buffer.h"
+
+TEST_CASE("RingBuffer against the vector queue it replaces", "[unit][ring_buffer]") {
+    std::mt19937 gen(8);
+    std::uniform_int_distribution<int> op_dist(0, 99);
+    std::uniform_int_distribution<size_t> num_dist(0, 40);
+
+    // a small start, so the ring grows while wrapped around
+    dramsim3::RingBuffer<uint64_t> ring(3);
+    std::vector<uint64_t> ref;
+    uint64_t next = 0;
+
+    for (int i = 0; i < 300000; i++) {
+        int op = op_dist(gen);
+        if (op == 0) {
+            ring.clear();
+            ref.clear();
+        } else if (op < 10) {
+            // the batched DREAM fan-out push
+            size_t num = num_dist(gen);
+            ring.push_back(next, num);
+            ref.insert(ref.end(), num, next);
+            next++;
+        } else if (op < 55) {
+            ring.push_back(next);
+            ref.push_back(next);
+            next++;
+        } else if (!ref.empty()) {
+            REQUIRE(ring.front() == ref.front());
+            ring.pop_front();
+            ref.erase(ref.begin());
+        }
+        REQUIRE(ring.size() == ref.size());
+        REQUIRE(ring.empty() == ref.empty());
+        if (!ref.empty()) {
+            REQUIRE(ring.front() == ref.front());
+        }
+    }
+
+    while (!ref.empty()) {
+        REQUIRE(ring.front() == ref.front());
+        ring.pop_front();
+        ref.erase(ref.begin());
+    }
+    REQUIRE(ring.empty());
+}
@@ -0,0 +1,101 @@
+#include <set>
+#include <vector>
+#include "catch.hpp"
+#include "rng.h"
+
+namespace {
+
+// the reference splitmix64 and xoshiro256** (Blackman and Vigna), as
+// published, with their global state
+uint64_t sm_state;
+uint64_t SplitMix64() {
+    uint64_t z = (sm_state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t s[4];
+uint64_t rotl(const uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+uint64_t Xoshiro256ss() {
+    const uint64_t result = rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+void SeedReference(uint64_t seed, uint64_t stream) {
+    sm_state = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+    for (auto& word : s) {
+        word = SplitMix64();
+    }
+}
+
+}  // namespace
+
+TEST_CASE("Rng against the reference xoshiro256**", "[unit][rng]") {
+    SECTION("splitmix64 known answer") {
+        sm_state = 0;
+        REQUIRE(SplitMix64() == 0xE220A8397B1DCDAFULL);
+    }
+
+    SECTION("same sequence as the reference") {
+        for (uint64_t seed : {0ULL, 1ULL, 1234ULL, ~0ULL}) {
+            for (uint64_t stream : {0ULL, 1ULL, 31ULL, 12345ULL}) {
+                dramsim3::Rng rng(seed, stream);
+                SeedReference(seed, stream);
+                for (int i = 0; i < 1000; i++) {
+                    REQUIRE(rng.Next() == Xoshiro256ss());
+                }
+            }
+        }
+    }
+
+    SECTION("streams of one seed differ") {
+        std::set<uint64_t> firsts;
+        for (uint64_t stream = 0; stream < 1024; stream++) {
+            dramsim3::Rng rng(1234, stream);
+            firsts.insert(rng.Next());
+        }
+        REQUIRE(firsts.size() == 1024);
+    }
+}
+
+TEST_CASE("Rng draws in range and evenly", "[unit][rng]") {
+    dramsim3::Rng rng(42, 7);
+
+    SECTION("Below") {
+        const uint32_t kBound = 10;
+        const int kDraws = 1000000;
+        std::vector<int> bins(kBound, 0);
+        for (int i = 0; i < kDraws; i++) {
+            uint32_t val = rng.Below(kBound);
+            REQUIRE(val < kBound);
+            bins[val]++;
+        }
+        // chi-square with 9 degrees of freedom, 27.9 is p = 0.001
+        double expected = kDraws / kBound, chi2 = 0;
+        for (int count : bins) {
+            chi2 += (count - expected) * (count - expected) / expected;
+        }
+        REQUIRE(chi2 < 27.9);
+        REQUIRE(rng.Below(1) == 0);
+    }
+
+    SECTION("Uniform") {
+        double sum = 0;
+        const int kDraws = 1000000;
+        for (int i = 0; i < kDraws; i++) {
+            double val = rng.Uniform();
+            REQUIRE(val >= 0.0);
+            REQUIRE(val < 1.0);
+            sum += val;
+        }
+        REQUIRE(sum / kDraws == Approx(0.5).epsilon(0.01));
+    }
+}
@@ -0,0 +1,58 @@
+#include <random>
+#include <vector>
+#include "catch.hpp"
+#include "rolling_window.h"
+
+namespace {
+
+// the per rank vector of expiry times RollingWindow replaces, as
+// UpdateActivationTimes() and IsFAWReady() used it
+struct RefWindow {
+    size_t num_events;
+    uint64_t window;
+    std::vector<uint64_t> expiry;
+
+    void Add(uint64_t clk) {
+        if (!expiry.empty() && clk >= expiry[0]) {
+            expiry.erase(expiry.begin());
+        }
+        expiry.push_back(clk + window);
+    }
+
+    bool Ready(uint64_t clk) const {
+        return expiry.empty() || clk >= expiry[0] || expiry.size() < num_events;
+    }
+};
+
+void CheckAgainstVector(int num_events, uint64_t window, unsigned seed) {
+    std::mt19937 gen(seed);
+    // mostly back to back ACT attempts, with an idle stretch now and then
+    std::uniform_int_distribution<int> op_dist(0, 99);
+    std::uniform_int_distribution<uint64_t> gap_dist(0, 3);
+    std::uniform_int_distribution<uint64_t> idle_dist(0, 2 * window);
+
+    dramsim3::RollingWindow ring(num_events, window);
+    RefWindow ref{static_cast<size_t>(num_events), window, {}};
+    uint64_t clk = 0;
+
+    for (int i = 0; i < 300000; i++) {
+        int op = op_dist(gen);
+        clk += op == 0 ? idle_dist(gen) : gap_dist(gen);
+        bool ready = ref.Ready(clk);
+        REQUIRE(ring.Ready(clk) == ready);
+        // an ACT only issues once the window allows it
+        if (ready && op < 70) {
+            ring.Add(clk);
+            ref.Add(clk);
+        }
+        REQUIRE(ref.expiry.size() <= static_cast<size_t>(num_events));
+    }
+}
+
+}  // namespace
+
+TEST_CASE("RollingWindow against the per rank vector", "[unit][rolling_window]") {
+    SECTION("tFAW") { CheckAgainstVector(4, 30, 11); }
+    SECTION("t32AW") { CheckAgainstVector(32, 330, 12); }
+    SECTION("zero window") { CheckAgainstVector(4, 0, 13); }
+}
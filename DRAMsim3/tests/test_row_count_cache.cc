@@ -0,0 +1,158 @@
+#include <random>
+#include <vector>
+#include "catch.hpp"
+#include "configuration.h"
+#include "row_count_cache.h"
+#include "simple_stats.h"
+
+namespace {
+
+// one struct per line, scanned in way order: the bit-PLRU of RowCountCache
+// written out plainly, or the true LRU of the LRUCache it replaces
+class RefCache {
+   public:
+    RefCache(int sets, int ways, bool lru)
+        : sets_(sets), ways_(ways), lru_(lru), clock_(0),
+          lines_(static_cast<size_t>(sets) * ways),
+          hits(0), misses(0), writebacks(0) {}
+
+    int64_t Access(uint64_t tag, uint64_t set_hint, bool is_write) {
+        Line* set = &lines_[(set_hint % sets_) * ways_];
+        for (int i = 0; i < ways_; i++) {
+            if (set[i].valid && set[i].tag == tag) {
+                if (is_write) {
+                    set[i].dirty = true;
+                } else {
+                    hits++;
+                }
+                Touch(set, i);
+                return 0;
+            }
+        }
+        if (!is_write) {
+            misses++;
+        }
+        int victim = Victim(set);
+        int64_t writeback_tag = -1;
+        if (set[victim].valid && set[victim].dirty) {
+            writebacks++;
+            writeback_tag = set[victim].tag;
+        }
+        set[victim].tag = tag;
+        set[victim].valid = true;
+        set[victim].dirty = is_write;
+        Touch(set, victim);
+        return writeback_tag;
+    }
+
+    uint64_t hits, misses, writebacks;
+
+   private:
+    struct Line {
+        Line() : tag(0), valid(false), dirty(false), mru(false), last_access(0) {}
+        uint64_t tag;
+        bool valid, dirty, mru;
+        uint64_t last_access;
+    };
+
+    int Victim(const Line* set) const {
+        for (int i = 0; i < ways_; i++) {
+            if (!set[i].valid) {
+                return i;
+            }
+        }
+        int victim = 0;
+        for (int i = 0; i < ways_; i++) {
+            if (lru_ ? set[i].last_access < set[victim].last_access : !set[i].mru) {
+                victim = i;
+                if (!lru_) {
+                    break;
+                }
+            }
+        }
+        return victim;
+    }
+
+    void Touch(Line* set, int way) {
+        set[way].last_access = clock_++;
+        set[way].mru = true;
+        for (int i = 0; i < ways_; i++) {
+            if (!set[i].mru) {
+                return;
+            }
+        }
+        for (int i = 0; i < ways_; i++) {
+            set[i].mru = i == way;
+        }
+    }
+
+    int sets_, ways_;
+    bool lru_;
+    uint64_t clock_;
+    std::vector<Line> lines_;
+};
+
+}  // namespace
+
+TEST_CASE("RowCountCache against a plain cache model", "[unit][row_count_cache]") {
+    dramsim3::Config config("tests/configs/hydra.ini", ".");
+    const int kSets = 8;
+
+    for (int ways : {1, 4, dramsim3::RowCountCache::kMaxWays}) {
+        dramsim3::SimpleStats stats(config, 0);
+        dramsim3::RowCountCache rcc(stats);
+        rcc.Init(kSets, ways);
+        RefCache plru(kSets, ways, false);
+        RefCache lru(kSets, ways, true);
+
+        std::mt19937 gen(9 + ways);
+        // about 1.5 lines per way, with a few hot tags
+        std::uniform_int_distribution<uint64_t> tag_dist(1, kSets * ways * 3 / 2);
+        std::uniform_int_distribution<int> op_dist(0, 9);
+        uint64_t reads = 0, writes = 0;
+        for (int i = 0; i < 200000; i++) {
+            int op = op_dist(gen);
+            uint64_t tag = op < 4 ? tag_dist(gen) % (ways + 1) + 1 : tag_dist(gen);
+            uint64_t set_hint = tag * 7;
+            bool is_write = op >= 7;
+            int64_t got = is_write ? rcc.Write(tag, set_hint) : rcc.Read(tag, set_hint);
+            REQUIRE(got == plru.Access(tag, set_hint, is_write));
+            lru.Access(tag, set_hint, is_write);
+            (is_write ? writes : reads)++;
+        }
+
+        REQUIRE(stats.GetECtr("hydra_rcc_reads") == reads);
+        REQUIRE(stats.GetECtr("hydra_rcc_writes") == writes);
+        REQUIRE(stats.GetECtr("hydra_rcc_hits") == plru.hits);
+        REQUIRE(stats.GetECtr("hydra_rcc_misses") == plru.misses);
+        REQUIRE(stats.GetECtr("hydra_rcc_writebacks") == plru.writebacks);
+        // bit-PLRU only approximates the LRU it replaces, it should not
+        // lose more than a few percent of the hits on a skewed stream
+        REQUIRE(plru.hits + plru.misses == lru.hits + lru.misses);
+        REQUIRE(plru.hits * 100 >= lru.hits * 95);
+    }
+}
+
+TEST_CASE("RowCountCache keeps a set that fits", "[unit][row_count_cache]") {
+    dramsim3::Config config("tests/configs/hydra.ini", ".");
+    dramsim3::SimpleStats stats(config, 0);
+    dramsim3::RowCountCache rcc(stats);
+    rcc.Init(4, 8);
+
+    // 8 dirty lines in set 1 stay resident however they are accessed, like
+    // they would under LRU
+    std::mt19937 gen(10);
+    std::uniform_int_distribution<uint64_t> tag_dist(100, 107);
+    for (uint64_t tag = 100; tag < 108; tag++) {
+        REQUIRE(rcc.Write(tag, 1) == -1);
+    }
+    for (int i = 0; i < 10000; i++) {
+        uint64_t tag = tag_dist(gen);
+        REQUIRE((i % 2 ? rcc.Read(tag, 1) : rcc.Write(tag, 1)) == 0);
+    }
+    // the next miss writes back a line that was not just touched
+    REQUIRE(rcc.Read(107, 1) == 0);
+    int64_t victim = rcc.Read(200, 1);
+    REQUIRE(victim >= 100);
+    REQUIRE(victim < 107);
+}
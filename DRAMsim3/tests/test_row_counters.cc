@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+#include "catch.hpp"
+#include "row_counters.h"
+
+namespace {
+
+// the flat per row vector RowCounters replaces, with the same saturation
+void CheckAgainstVector(uint32_t limit, unsigned seed) {
+    const int kRows = 5000;  // not a multiple of the page size
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> row_dist(0, kRows - 1);
+    // a few rows take most of the ACTs, so some pass 16 bits
+    std::uniform_int_distribution<int> hot_dist(0, 3);
+    std::uniform_int_distribution<int> op_dist(0, 999);
+    std::uniform_int_distribution<uint32_t> val_dist(0, 200000);
+    std::uniform_int_distribution<int> len_dist(1, 2048);
+
+    dramsim3::RowCounters counters(kRows, limit);
+    std::vector<uint32_t> ref(kRows, 0);
+
+    for (int i = 0; i < 400000; i++) {
+        int op = op_dist(gen);
+        if (op < 5) {
+            // the refresh walk over [first, first + num)
+            int first = row_dist(gen);
+            int num = std::min(len_dist(gen), kRows - first);
+            std::vector<std::pair<uint32_t, uint64_t> > got;
+            counters.ResetRows(first, num,
+                [&got](uint32_t val, uint64_t count) {
+                    got.emplace_back(val, count);
+                },
+                [&got](const uint16_t* vals, int n) {
+                    REQUIRE(n > 0);
+                    for (int i = 0; i < n; i++) {
+                        // wide values never come through the bulk path
+                        REQUIRE(vals[i] < 65535);
+                        got.emplace_back(vals[i], 1);
+                    }
+                });
+            uint64_t total = 0;
+            std::vector<uint32_t> seen;
+            for (const auto& run : got) {
+                // single values are only batched for zeros
+                REQUIRE((run.second == 1 || run.first == 0));
+                seen.insert(seen.end(), run.second, run.first);
+                total += run.second;
+            }
+            REQUIRE(total == static_cast<uint64_t>(num));
+            REQUIRE(std::equal(seen.begin(), seen.end(), ref.begin() + first));
+            std::fill(ref.begin() + first, ref.begin() + first + num, 0);
+        } else if (op < 10) {
+            // zeros, values just below the 16 bit escape and wide values
+            int row = op < 8 ? hot_dist(gen) * 1024 + 7 : row_dist(gen);
+            uint32_t val = op < 7 ? 0 : (op < 9 ? 65530 + op_dist(gen) % 10 : val_dist(gen));
+            counters.Set(row, val);
+            ref[row] = std::min(val, limit);
+        } else if (op == 10) {
+            counters.Clear();
+            std::fill(ref.begin(), ref.end(), 0);
+        } else {
+            int row = op < 800 ? hot_dist(gen) * 1024 + 7 : row_dist(gen);
+            counters.Increment(row);
+            ref[row] = std::min(ref[row] + 1, limit);
+        }
+
+        int row = op < 500 ? hot_dist(gen) * 1024 + 7 : row_dist(gen);
+        REQUIRE(counters.Get(row) == ref[row]);
+    }
+    for (int row = 0; row < kRows; row++) {
+        REQUIRE(counters.Get(row) == ref[row]);
+    }
+}
+
+}  // namespace
+
+TEST_CASE("RowCounters against a per row vector", "[unit][row_counters]") {
+    SECTION("no limit, counters past 16 bits") { CheckAgainstVector(UINT32_MAX, 5); }
+    SECTION("saturating below 16 bits") { CheckAgainstVector(500, 6); }
+    SECTION("saturating above 16 bits") { CheckAgainstVector(70000, 7); }
+}
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "catch.hpp"
+#include "common.h"
+#include "json.hpp"
+#include "memory_system.h"
+
+namespace {
+
+nlohmann::json ReadJson(const std::string& path) {
+    std::ifstream in(path);
+    REQUIRE(in.good());
+    nlohmann::json j;
+    in >> j;
+    return j;
+}
+
+std::vector<dramsim3::Transaction> ReadTrace() {
+    std::ifstream trace("tests/example.trace");
+    REQUIRE(trace.good());
+    std::vector<dramsim3::Transaction> transactions;
+    dramsim3::Transaction trans;
+    while (trace >> trans) {
+        transactions.push_back(trans);
+    }
+    return transactions;
+}
+
+// Issues transactions [first, last) of the trace. Idle stretches between
+// requests are skipped with AdvanceTo(), so the run takes seconds rather
+// than ticking all of the ~15M cycles.
+void IssueTrace(dramsim3::MemorySystem& memory_system,
+                const std::vector<dramsim3::Transaction>& transactions,
+                size_t first, size_t last, uint64_t& clk) {
+    for (size_t i = first; i < last; i++) {
+        const auto& trans = transactions[i];
+        if (trans.added_cycle > clk) {
+            clk = trans.added_cycle;
+            memory_system.AdvanceTo(clk);
+        }
+        while (!memory_system.WillAcceptTransaction(trans.addr, trans.is_write)) {
+            memory_system.ClockTick();
+            clk++;
+        }
+        memory_system.AddTransaction(trans.addr, trans.is_write);
+    }
+}
+
+// drains the queues and lets a few refresh windows pass
+nlohmann::json FinishTrace(dramsim3::MemorySystem& memory_system, uint64_t clk,
+                           const std::string& prefix,
+                           const std::string& output_dir) {
+    memory_system.AdvanceTo(clk + 1000000);
+    memory_system.PrintStats(false);
+    return ReadJson(output_dir + "/" + prefix + ".json");
+}
+
+// Runs tests/example.trace through one config and returns its stats.
+nlohmann::json RunTrace(const std::string& prefix, const std::string& output_dir) {
+    dramsim3::MemorySystem memory_system(
+        "tests/configs/" + prefix + ".ini", output_dir,
+        [](uint64_t) {}, [](uint64_t) {});
+    const auto transactions = ReadTrace();
+    uint64_t clk = 0;
+    IssueTrace(memory_system, transactions, 0, transactions.size(), clk);
+    return FinishTrace(memory_system, clk, prefix, output_dir);
+}
+
+}  // namespace
+
+// The final stats of one config per mitigation, against those of a known
+// good run in tests/baseline. A change that is meant to move the results
+// has to update the baseline: on a mismatch the new JSON is left in the
+// reported directory, copy it over the old one.
+//
+// Where each baseline comes from, checked against the baseline commit:
+// - graphene and abacus_eager are what the baseline commit produces
+// - hydra changed with [user-017], counter fetches no longer stall the
+//   channel
+// - para_ab_eager and dream_rand8 changed with [user-018], PARA and DREAM
+//   draw from seeded per-bank generators instead of rand()
+// No other commit moves them.
+TEST_CASE("Stats JSON against the baseline", "[regression]") {
+    char dir_template[] = "/tmp/dramsim3test.XXXXXX";
+    REQUIRE(mkdtemp(dir_template) != nullptr);
+    const std::string output_dir = dir_template;
+
+    // each config with the DRFM command its mitigation issues
+    const std::vector<std::pair<std::string, std::string> > runs = {
+        {"para_ab_eager", "num_drfmab_cmds"}, {"graphene", "num_drfmsb_cmds"},
+        {"hydra", "num_drfmsb_cmds"},         {"dream_rand8", "num_drfmab_cmds"},
+        {"abacus_eager", "num_drfmab_cmds"}};
+    for (const auto& run : runs) {
+        const std::string& prefix = run.first;
+        INFO(prefix << ".json in " << output_dir);
+        auto baseline = ReadJson("tests/baseline/" + prefix + ".json").flatten();
+        auto got = RunTrace(prefix, output_dir).flatten();
+        // stat by stat, so a failure names the ones that moved
+        for (auto it = baseline.begin(); it != baseline.end(); ++it) {
+            INFO(it.key());
+            REQUIRE(got.count(it.key()) == 1);
+            REQUIRE(got[it.key()] == it.value());
+        }
+        REQUIRE(got.size() == baseline.size());
+        // a baseline where the mitigation never fires would not test it
+        REQUIRE(got["/0/" + run.second] > 0);
+        remove((output_dir + "/" + prefix + ".json").c_str());
+        remove((output_dir + "/" + prefix + ".txt").c_str());
+    }
+    rmdir(output_dir.c_str());
+}
+
+// A memory system loaded from the state of another one half way through the
+// trace finishes it with the same completions and stats as the one that
+// saved it.
+TEST_CASE("Saved state continues the run exactly", "[regression]") {
+    char dir_template[] = "/tmp/dramsim3test.XXXXXX";
+    REQUIRE(mkdtemp(dir_template) != nullptr);
+    const std::string saved_dir = std::string(dir_template) + "/saved";
+    const std::string loaded_dir = std::string(dir_template) + "/loaded";
+    REQUIRE(mkdir(saved_dir.c_str(), 0755) == 0);
+    REQUIRE(mkdir(loaded_dir.c_str(), 0755) == 0);
+
+    const auto transactions = ReadTrace();
+    const size_t half = transactions.size() / 2;
+    for (const std::string prefix : {"hydra", "dream_rand8"}) {
+        INFO(prefix);
+        const std::string config = "tests/configs/" + prefix + ".ini";
+        // completions as (cycle, address, is_write), from the load on
+        uint64_t clk = 0;
+        std::vector<std::vector<uint64_t> > saved_done, loaded_done;
+        auto* done = &saved_done;
+        auto read_done = [&](uint64_t addr) { done->push_back({clk, addr, 0}); };
+        auto write_done = [&](uint64_t addr) { done->push_back({clk, addr, 1}); };
+
+        dramsim3::MemorySystem saved(config, saved_dir, read_done, write_done);
+        IssueTrace(saved, transactions, 0, half, clk);
+        std::stringstream state;
+        saved.SaveState(state);
+        const uint64_t saved_clk = clk;
+        saved_done.clear();
+
+        IssueTrace(saved, transactions, half, transactions.size(), clk);
+        auto saved_stats =
+            FinishTrace(saved, clk, prefix, saved_dir).flatten();
+
+        done = &loaded_done;
+        clk = saved_clk;
+        dramsim3::MemorySystem loaded(config, loaded_dir, read_done,
+                                      write_done);
+        loaded.LoadState(state);
+        IssueTrace(loaded, transactions, half, transactions.size(), clk);
+        auto loaded_stats =
+            FinishTrace(loaded, clk, prefix, loaded_dir).flatten();
+
+        REQUIRE(!saved_done.empty());
+        REQUIRE(loaded_done == saved_done);
+        for (auto it = saved_stats.begin(); it != saved_stats.end(); ++it) {
+            INFO(it.key());
+            REQUIRE(loaded_stats.count(it.key()) == 1);
+            REQUIRE(loaded_stats[it.key()] == it.value());
+        }
+        REQUIRE(loaded_stats.size() == saved_stats.size());
+        for (const auto& dir : {saved_dir, loaded_dir}) {
+            remove((dir + "/" + prefix + ".json").c_str());
+            remove((dir + "/" + prefix + ".txt").c_str());
+        }
+    }
+    rmdir(saved_dir.c_str());
+    rmdir(loaded_dir.c_str());
+    rmdir(dir_template);
+}
@@ -0,0 +1,115 @@
+#include <map>
+#include <random>
+#include <vector>
+#include "catch.hpp"
+#include "trans_table.h"
+
+namespace {
+
+// added_cycle doubles as an id to follow each transaction
+dramsim3::Transaction MakeTrans(uint64_t addr, uint64_t id) {
+    dramsim3::Transaction trans(addr, false);
+    trans.added_cycle = id;
+    return trans;
+}
+
+}  // namespace
+
+TEST_CASE("TransTable against std::multimap", "[unit][trans_table]") {
+    std::mt19937 gen(1);
+    // few addresses so that many transactions merge, spread so that some
+    // share a home slot
+    std::uniform_int_distribution<uint64_t> addr_dist(0, 63);
+    std::uniform_int_distribution<int> op_dist(0, 9);
+
+    dramsim3::TransTable table(8);
+    std::multimap<uint64_t, dramsim3::Transaction> ref;
+
+    for (uint64_t id = 0; id < 100000; id++) {
+        uint64_t addr = addr_dist(gen) * 0x40 + (addr_dist(gen) & 1) * 0x100000;
+        if (op_dist(gen) < 6) {
+            ref.insert(std::make_pair(addr, MakeTrans(addr, id)));
+            REQUIRE(table.Insert(MakeTrans(addr, id)) == ref.count(addr));
+        } else {
+            std::vector<uint64_t> got, expected;
+            size_t num = table.Remove(addr, [&got](const dramsim3::Transaction& t) {
+                got.push_back(t.added_cycle);
+            });
+            auto range = ref.equal_range(addr);
+            for (auto it = range.first; it != range.second; ++it) {
+                expected.push_back(it->second.added_cycle);
+            }
+            ref.erase(addr);
+            REQUIRE(num == expected.size());
+            REQUIRE(got == expected);
+        }
+
+        uint64_t probe = addr_dist(gen) * 0x40;
+        REQUIRE(table.Count(probe) == ref.count(probe));
+        auto it = ref.find(probe);
+        if (it == ref.end()) {
+            REQUIRE(table.Front(probe) == nullptr);
+        } else {
+            REQUIRE(table.Front(probe) != nullptr);
+            REQUIRE(table.Front(probe)->added_cycle == it->second.added_cycle);
+        }
+    }
+}
+
+TEST_CASE("TransWheel against a flat return queue", "[unit][trans_table]") {
+    std::mt19937 gen(2);
+    std::uniform_int_distribution<int> num_dist(0, 3);
+    // mostly within the initial size, a few far enough out to grow the wheel
+    std::uniform_int_distribution<uint64_t> delay_dist(0, 40);
+    std::uniform_int_distribution<int> far_dist(0, 99);
+
+    dramsim3::TransWheel wheel(16);
+    std::vector<dramsim3::Transaction> ref;
+    uint64_t id = 0;
+    uint64_t clk = 0;
+
+    while (clk < 200000) {
+        // new transactions never complete before clk, a few are already due
+        int num = num_dist(gen);
+        for (int i = 0; i < num; i++) {
+            dramsim3::Transaction trans = MakeTrans(0, id++);
+            trans.complete_cycle = clk + delay_dist(gen);
+            if (far_dist(gen) == 0) {
+                trans.complete_cycle += 1000;
+            }
+            wheel.Push(trans);
+            ref.push_back(trans);
+        }
+
+        std::vector<dramsim3::Transaction> done;
+        wheel.Collect(clk, done);
+        std::vector<uint64_t> got, expected;
+        for (const auto& trans : done) {
+            got.push_back(trans.added_cycle);
+        }
+        auto it = ref.begin();
+        while (it != ref.end()) {
+            if (clk >= it->complete_cycle) {
+                expected.push_back(it->added_cycle);
+                it = ref.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        REQUIRE(got == expected);
+        REQUIRE(wheel.Empty() == ref.empty());
+
+        // idle stretches are skipped up to the next completion, the way
+        // AdvanceTo() does
+        if (num == 0 && !ref.empty() && far_dist(gen) < 10) {
+            uint64_t next = ref[0].complete_cycle;
+            for (const auto& trans : ref) {
+                next = std::min(next, trans.complete_cycle);
+            }
+            REQUIRE(wheel.NextCycle() == next);
+            clk = next;
+        } else {
+            clk++;
+        }
+    }
+}
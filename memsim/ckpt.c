@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <zlib.h>
+
+#include "externs.h"
+#include "ckpt.h"
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+gzFile ckpt_open(char *fname, const char *mode)
+{
+  gzFile f = gzopen(fname, mode);
+  if(f == NULL)
+  {
+    die_message("Unable to open the checkpoint file. Dying ...\n");
+  }
+  gzbuffer(f, 256*1024);
+  return f;
+}
+
+
+void ckpt_close(gzFile f)
+{
+  if(gzclose(f) != Z_OK)
+  {
+    die_message("Unable to write the checkpoint file. Dying ...\n");
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////
+// gzwrite/gzread take an unsigned length, go in chunks
+////////////////////////////////////////////////////////////////////
+
+void ckpt_write(gzFile f, const void *buf, uns64 bytes)
+{
+  const char *p = (const char *) buf;
+  while(bytes)
+  {
+    unsigned len = bytes < (1u << 30) ? (unsigned) bytes : (1u << 30);
+    if(gzwrite(f, p, len) != (int) len)
+    {
+      die_message("Unable to write the checkpoint file. Dying ...\n");
+    }
+    p += len;
+    bytes -= len;
+  }
+}
+
+
+void ckpt_read(gzFile f, void *buf, uns64 bytes)
+{
+  char *p = (char *) buf;
+  while(bytes)
+  {
+    unsigned len = bytes < (1u << 30) ? (unsigned) bytes : (1u << 30);
+    if(gzread(f, p, len) != (int) len)
+    {
+      die_message("Truncated or corrupt checkpoint file. Dying ...\n");
+    }
+    p += len;
+    bytes -= len;
+  }
+}
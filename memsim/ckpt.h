@@ -0,0 +1,28 @@
+#ifndef CKPT_H
+#define CKPT_H
+
+#include <zlib.h>
+#include "global_types.h"
+
+
+#define CKPT_MAGIC    "MEMSIMCK"
+#define CKPT_VERSION  2
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Warmed-state checkpoints: every module writes (and reads back, in the same
+// order) its own state through these, into one gzip'd file
+//////////////////////////////////////////////////////////////////////////////
+
+gzFile  ckpt_open(char *fname, const char *mode);
+void    ckpt_close(gzFile f);
+void    ckpt_write(gzFile f, const void *buf, uns64 bytes);
+void    ckpt_read(gzFile f, void *buf, uns64 bytes);
+
+#define CKPT_WRITE(f, x)  ckpt_write(f, &(x), sizeof (x))
+#define CKPT_READ(f, x)   ckpt_read(f, &(x), sizeof (x))
+
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#endif // CKPT_H
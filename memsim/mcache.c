@@ -3,11 +3,15 @@
 #include <stdlib.h>
 
 #include "mcache.h"
+#include "ckpt.h"
+#include "rng.h"
 
 
 #define MCACHE_SRRIP_MAX  7
 #define MCACHE_SRRIP_INIT 1
 
+extern void die_message(const char *msg);
+
 ////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////
 
@@ -266,7 +270,7 @@ uns
 mcache_find_victim_rnd (MCache *c,  uns set)
 {
     uns start = set   * c->assocs;    
-    uns victim = start + rand()%c->assocs; 
+    uns victim = start + rng_rand()%c->assocs; 
 
     return  victim;   
 }
@@ -347,3 +351,27 @@ void  mcache_print_stats(MCache *c, char *header)
 
 
 
+
+////////////////////////////////////////////////////////////
+// The whole cache (stats included), the geometry has to match
+////////////////////////////////////////////////////////////
+
+void mcache_ckpt_write(MCache *c, gzFile f)
+{
+  CKPT_WRITE(f, *c);
+  ckpt_write(f, c->entries, (uns64)c->sets * c->assocs * sizeof(MCache_Entry));
+}
+
+
+void mcache_ckpt_read(MCache *c, gzFile f)
+{
+  MCache saved;
+  CKPT_READ(f, saved);
+  if(saved.sets != c->sets || saved.assocs != c->assocs || saved.repl_policy != c->repl_policy)
+  {
+    die_message("Checkpoint was taken with a different cache geometry. Dying ...\n");
+  }
+  saved.entries = c->entries;
+  *c = saved;
+  ckpt_read(f, c->entries, (uns64)c->sets * c->assocs * sizeof(MCache_Entry));
+}
@@ -1,6 +1,7 @@
 #ifndef MCACHE_H
 #define MCACHE_H
 
+#include <zlib.h>
 #include "global_types.h"
 
 
@@ -66,6 +67,8 @@ uns     mcache_find_victim_rnd   (MCache *c, uns set);
 uns     mcache_find_victim_srrip   (MCache *c, uns set);
 
 void    mcache_print_stats(MCache *c, char *header);
+void    mcache_ckpt_write(MCache *c, gzFile f);
+void    mcache_ckpt_read(MCache *c, gzFile f);
 ///////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////
 
@@ -4,11 +4,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <inttypes.h>
-#include <unistd.h>
-#include <zlib.h>
 
 #include "externs.h"
 #include "mcore.h"
+#include "ckpt.h"
 
 #define MCORE_STOP_ON_EOF       0
 #define DEFAULT_MEM_DELAY    5000000
@@ -44,16 +43,7 @@ MCore *mcore_new(MemSys *memsys, OS *os, MCache *l3cache, char *addr_trace_fname
 ////////////////////////////////////////////////////////////////////
 void mcore_init_trace(MCore *c)
 {
-  if ((c->addr_trace = gzopen(c->addr_trace_fname, "r")) == NULL)
-  {
-    //---- maybe put random sleep and try again?
-    printf("Problems initializing Core: %u ... Trying again\n", (uns)c->id);
-    sleep(rand()%10);
-    if ((c->addr_trace = gzopen(c->addr_trace_fname, "r")) == NULL)
-    {
-      die_message("Unable to open the input trace file. Dying ...\n");
-    }
-  }
+  c->addr_trace = trace_open(c->addr_trace_fname, c->id);
 }
 
 
@@ -182,7 +172,7 @@ void mcore_cycle (MCore *c)
 void mcore_read_trace (MCore *c)
 {
     mcore_fread_trace(c);
-    if(gzeof(c->addr_trace) || ((!c->done) && (c->inst_num >= INST_LIMIT)))
+    if(c->trace_eof || ((!c->done) && (c->inst_num >= INST_LIMIT)))
     {
       if(!c->done)
       {
@@ -200,8 +190,7 @@ void mcore_read_trace (MCore *c)
     
       if(!MCORE_STOP_ON_EOF)
       {
-        gzclose(c->addr_trace);
-        mcore_init_trace(c);
+        trace_rewind(c->addr_trace);
         mcore_fread_trace(c);
         c->lifetime_inst_count += c->inst_num;
         c->inst_num = 0;
@@ -243,7 +232,7 @@ void mcore_print_stats(MCore *c)
   
   printf("\n");
 
-  gzclose(c->addr_trace);
+  trace_close(c->addr_trace);
 }
 
 
@@ -252,14 +241,12 @@ void mcore_print_stats(MCore *c)
 
 void mcore_fread_trace (MCore *c)
 {
-    c->trace_inst_num = 0;
-    c->trace_va = 0;
-    c->trace_wb = 0;
-
-    gzread ( c->addr_trace, &c->trace_inst_num, 5);
-    gzread ( c->addr_trace, &c->trace_wb, 1);
-    gzread ( c->addr_trace, &c->trace_va, 4);
+    TraceRecord rec;
 
+    c->trace_eof = !trace_read(c->addr_trace, &rec);
+    c->trace_inst_num = rec.inst_num;
+    c->trace_wb = rec.wb;
+    c->trace_va = rec.va;
 }
 
 
@@ -274,6 +261,44 @@ void mcore_print_state(MCore *c)
 }
 
 
+////////////////////////////////////////////////////////////
+// Core state, ROB included, and where it is in its trace.
+// The trace only has to hold the same records, it may be
+// another file (e.g. in the native format).
+////////////////////////////////////////////////////////////
+
+void mcore_ckpt_write(MCore *c, gzFile f)
+{
+  uns64 trace_offset = trace_tell(c->addr_trace);
+
+  CKPT_WRITE(f, *c);
+  CKPT_WRITE(f, trace_offset);
+}
+
+
+void mcore_ckpt_read(MCore *c, gzFile f)
+{
+  MCore *saved = (MCore *) malloc (sizeof (MCore));
+  uns64 trace_offset;
+
+  ckpt_read(f, saved, sizeof (MCore));
+  CKPT_READ(f, trace_offset);
+  if(saved->id != c->id)
+  {
+    die_message("Checkpoint cores are out of order. Dying ...\n");
+  }
+  saved->memsys     = c->memsys;
+  saved->os         = c->os;
+  saved->l3cache    = c->l3cache;
+  saved->addr_trace = c->addr_trace;
+  strcpy(saved->addr_trace_fname, c->addr_trace_fname);
+  *c = *saved;
+  free(saved);
+
+  trace_seek(c->addr_trace, trace_offset);
+}
+
+
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 
@@ -9,7 +9,7 @@
 #endif
 #include "os.h"
 #include "mcache.h"
-#include <zlib.h>
+#include "trace.h"
 
 
 #define MAX_ROB_ENTRIES 1024
@@ -54,7 +54,7 @@ struct MCore
     OS  *os;
   
     char  addr_trace_fname[1024];
-    gzFile addr_trace;
+    TraceCursor *addr_trace; // shared with the cores running the same trace
     
     uns   done;
 
@@ -69,6 +69,7 @@ struct MCore
     uns    trace_iaddr; // four bytes only IA
     Addr   trace_va;
     Flag   trace_wb;
+    Flag   trace_eof; // last read went past the end of the trace
     uns    trace_dhits;
     uns64  trace_inst_num_clone;//debug
 
@@ -111,6 +112,8 @@ void   mcore_print_state(MCore *c);
 void   mcore_read_trace(MCore *c);
 void   mcore_fread_trace(MCore *c);
 void   mcore_init_trace(MCore *c);
+void   mcore_ckpt_write(MCore *c, gzFile f);
+void   mcore_ckpt_read(MCore *c, gzFile f);
 
 Flag   mcore_retry_sleeping_request(MCore *c);
 
@@ -5,9 +5,14 @@
 #include <math.h>
 #include <iostream>
 #include <functional>
+#include <fstream>
+#include <sstream>
 #include "externs.h"
 #include "memsys_dramsim3.h"
 #include "mcore.h"
+#include "ckpt.h"
+
+static std::string memsys_config_text(void);
 
 extern MCore *mcore[MAX_THREADS];
 
@@ -20,6 +25,8 @@ MemSys *memsys_new(void)
   std::cout << "Config: " << DRAMSIM3CFG << std::endl;
   m->mainmem = dramsim3::GetMemorySystem(DRAMSIM3CFG, ".", std::bind(&memsys_callback, m, std::placeholders::_1), std::bind(&memsys_callback_write, m, std::placeholders::_1));
   m->lines_in_mainmem_rbuf = MEM_PAGESIZE/LINESIZE; // static
+  m->cycle = 0;
+  m->config = memsys_config_text();
    
   return m;
 }
@@ -81,6 +88,7 @@ Flag memsys_access(MemSys *m, Addr lineaddr,  uns coreid, uns robid, uns64 inst_
 void  memsys_cycle(MemSys *m)
 {
   m->mainmem->ClockTick(); 
+  m->cycle++;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -129,3 +137,114 @@ void memsys_callback_write(MemSys *m, Addr byteaddress)
 
 //////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////
+// The checkpoint keeps DRAMsim3's own state (queues, bank timing, row
+// counters and mitigation tables, stats) next to the MSHR, so a run with
+// the same config continues exactly where the warmup stopped. It is only
+// loaded into that config, with any other one the memory system starts
+// cold and the reads in flight complete right away.
+////////////////////////////////////////////////////////////////////
+
+static std::string memsys_config_text(void)
+{
+  std::ifstream in(DRAMSIM3CFG);
+  std::stringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+
+static void memsys_cold_start(MemSys *m)
+{
+  printf("DRAMsim3 config differs from the warmed up one, memory system starts cold\n");
+  for(auto it = m->mshr.begin(); it != m->mshr.end(); ++it)
+  {
+    mcore_rob_wakeup(mcore[it->second.coreid], it->second.robid, it->second.inst_num);
+  }
+  m->mshr.clear();
+  m->cycle = 0;
+}
+
+
+void memsys_ckpt_write(MemSys *m, gzFile f)
+{
+  uns64 config_bytes = m->config.size();
+  uns64 num_mshr = m->mshr.size();
+  std::ostringstream state;
+
+  m->mainmem->SaveState(state);
+  std::string state_bytes = state.str();
+  uns64 num_state = state_bytes.size();
+
+  CKPT_WRITE(f, config_bytes);
+  ckpt_write(f, m->config.data(), config_bytes);
+  CKPT_WRITE(f, m->cycle);
+  CKPT_WRITE(f, num_mshr);
+  for(auto it = m->mshr.begin(); it != m->mshr.end(); ++it)
+  {
+    uns64 entry[4] = {it->first, it->second.coreid, it->second.robid, it->second.inst_num};
+    CKPT_WRITE(f, entry);
+  }
+  CKPT_WRITE(f, num_state);
+  ckpt_write(f, state_bytes.data(), num_state);
+}
+
+
+void memsys_ckpt_read(MemSys *m, gzFile f)
+{
+  uns64 config_bytes, num_mshr, num_state;
+
+  CKPT_READ(f, config_bytes);
+  std::string config(config_bytes, '\0');
+  ckpt_read(f, &config[0], config_bytes);
+  CKPT_READ(f, m->cycle);
+  CKPT_READ(f, num_mshr);
+  for(uns64 ii = 0; ii < num_mshr; ii++)
+  {
+    uns64 entry[4];
+    CKPT_READ(f, entry);
+    memsys_mshr_insert(m, entry[0], entry[1], entry[2], entry[3]);
+  }
+  CKPT_READ(f, num_state);
+  std::string state_bytes(num_state, '\0');
+  ckpt_read(f, &state_bytes[0], num_state);
+
+  if(config != m->config)
+  {
+    memsys_cold_start(m);
+    return;
+  }
+  std::istringstream state(state_bytes);
+  m->mainmem->LoadState(state);
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Forking off a warmed up run: DRAMsim3's channel threads are stopped
+// first, they would not survive the fork. A child with the warmed up
+// config keeps the inherited memory system and restarts them, any other
+// one switches to a cold memory system of DRAMSIM3CFG (the inherited one
+// is left alone, its pages stay shared with the parent).
+////////////////////////////////////////////////////////////////////
+
+void memsys_fork_prepare(MemSys *m)
+{
+  m->mainmem->StopWorkers();
+}
+
+
+void memsys_fork_child(MemSys *m)
+{
+  std::string warm_config = m->config;
+
+  std::cout << "Config: " << DRAMSIM3CFG << std::endl;
+  if(memsys_config_text() == warm_config)
+  {
+    m->mainmem->StartWorkers();
+    return;
+  }
+  m->mainmem = dramsim3::GetMemorySystem(DRAMSIM3CFG, ".", std::bind(&memsys_callback, m, std::placeholders::_1), std::bind(&memsys_callback_write, m, std::placeholders::_1));
+  m->config = memsys_config_text();
+  memsys_cold_start(m);
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <unordered_map>
+#include <string>
+#include <zlib.h>
 #include "global_types.h"
 
 
@@ -49,6 +51,9 @@ struct MemSys
   dramsim3::MemorySystem          *mainmem;
   uns64                 lines_in_mainmem_rbuf;
   std::unordered_map<uns64, MSHR_Entry> mshr;
+
+  uns64                 cycle; // DRAMsim3 clock
+  std::string           config; // text of the DRAMsim3 config
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -64,6 +69,10 @@ void    memsys_callback(MemSys *m, Addr lineaddr);
 void    memsys_callback_write(MemSys *m, Addr lineaddr);
 Flag    memsys_isindrfm(MemSys *m, Addr lineaddr);
 Flag    memsys_isinref(MemSys *m, Addr lineaddr);
+void    memsys_ckpt_write(MemSys *m, gzFile f);
+void    memsys_ckpt_read(MemSys *m, gzFile f);
+void    memsys_fork_prepare(MemSys *m);
+void    memsys_fork_child(MemSys *m);
 
 ///////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////
\ No newline at end of file
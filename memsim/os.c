@@ -4,9 +4,12 @@
 #include <stdlib.h>
 #include <math.h>
 #include "os.h"
+#include "ckpt.h"
+#include "rng.h"
 
 extern uns OS_PAGESIZE;
 extern uns LINESIZE;
+extern void die_message(const char *msg);
 
 
 
@@ -57,7 +60,7 @@ uns64    os_get_victim_from_ipt(OS *os)
   assert(os->s_miss_count < 0.95*os->num_pages);
 
   while(tries < MAX_TRIES){
-    uns victim = rand()%os->num_pages;
+    uns victim = rng_rand()%os->num_pages;
     if(os->ipt[victim] == FALSE){
       os->ipt[victim] = TRUE;
       return victim;
@@ -92,3 +95,45 @@ Addr os_v2p_lineaddr(OS *os, Addr lineaddr, uns tid)
   Addr retval  = (pfn * os->lines_in_page) + lineid;
   return retval;
 }
+
+////////////////////////////////////////////////////////////
+// Page table and the frames handed out so far
+////////////////////////////////////////////////////////////
+
+void os_ckpt_write(OS *os, gzFile f)
+{
+  uns64 num_entries = os->pt.size();
+
+  CKPT_WRITE(f, os->num_pages);
+  CKPT_WRITE(f, os->s_miss_count);
+  ckpt_write(f, os->ipt, os->num_pages * sizeof(Flag));
+  CKPT_WRITE(f, num_entries);
+  for(auto it = os->pt.begin(); it != os->pt.end(); ++it)
+  {
+    uns64 entry[2] = {it->first, it->second};
+    CKPT_WRITE(f, entry);
+  }
+}
+
+
+void os_ckpt_read(OS *os, gzFile f)
+{
+  uns64 num_pages, num_entries;
+
+  CKPT_READ(f, num_pages);
+  if(num_pages != os->num_pages)
+  {
+    die_message("Checkpoint was taken with a different memory size. Dying ...\n");
+  }
+  CKPT_READ(f, os->s_miss_count);
+  ckpt_read(f, os->ipt, os->num_pages * sizeof(Flag));
+  CKPT_READ(f, num_entries);
+  os->pt.clear();
+  os->pt.reserve(num_entries);
+  for(uns64 ii = 0; ii < num_entries; ii++)
+  {
+    uns64 entry[2];
+    CKPT_READ(f, entry);
+    os->pt[entry[0]] = entry[1];
+  }
+}
@@ -2,6 +2,7 @@
 #define OS_H
 
 #include <unordered_map>
+#include <zlib.h>
 #include "global_types.h"
 
 
@@ -32,6 +33,8 @@ struct OS
 OS*     os_new(uns num_pages, uns num_threads);
 uns64   os_vpn_to_pfn(OS *os, uns vpn, uns tid);
 void    os_print_stats(OS *os);
+void    os_ckpt_write(OS *os, gzFile f);
+void    os_ckpt_read(OS *os, gzFile f);
 
 uns64   os_get_victim_from_ipt(OS *os);
 Addr    os_v2p_lineaddr(OS *os, Addr lineaddr, uns tid);
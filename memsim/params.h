@@ -67,6 +67,16 @@ uns64       MEM_RSRV_MB      = 0; // reserving memory for metadata (e.g. CRA)
 
 uns64       RAND_SEED       = 1234;
 
+char        CKPT_WRITE_FILE[1024] = ""; // write a warmed-state checkpoint here
+uns64       CKPT_INST       = 0; // ... once every core is this many instructions in
+char        CKPT_READ_FILE[1024]  = ""; // start from this checkpoint
+
+#define MAX_FANOUT 64
+std::string FANOUT_CFG[MAX_FANOUT]; // DRAMsim3 configs forked off at -ckpt_inst
+char        FANOUT_OUT[MAX_FANOUT][1024]; // ... and where their output goes
+int         num_fanout = 0;
+uns64       FANOUT_JOBS     = 0; // fan-out children running at once, 0: one per online CPU
+
 uns64       cycle;
 uns64       last_printdot_cycle;
 char        addr_trace_filename[256][1024];
@@ -90,6 +100,12 @@ void die_usage() {
     printf("               -l3assoc     <num>    Set L3  Cache assoc <num> (Default: 16)\n");
     printf("               -l3perfect            Set L3  to 100 percent hit rate(Default:off)\n");
     printf("               -memclosepage         Set DRAM to close page (Default:off)\n");
+    printf("               -ckpt_write  <file>   Write a checkpoint once every core is -ckpt_inst instructions in\n");
+    printf("               -ckpt_inst   <num>    Instructions per core before the checkpoint (Default: 0)\n");
+    printf("               -ckpt_read   <file>   Start from a checkpoint\n");
+    printf("               -fanout <cfg> <file>  Fork a run of DRAMsim3 config <cfg> once every core is -ckpt_inst\n");
+    printf("                                     instructions in, output to <file> (repeat for each config)\n");
+    printf("               -fanout_jobs <num>    Fan-out runs at a time, 0 for one per CPU (Default: 0)\n");
 
     exit(0);
 }
@@ -380,6 +396,48 @@ void read_params(int argc, char **argv){
 				ii += 1;
 			}
 	    }
+		else if (!strcmp(argv[ii], "-ckpt_write")) {
+			if (ii < argc - 1) {
+				strcpy(CKPT_WRITE_FILE, argv[ii + 1]);
+				ii += 1;
+			}
+		}
+		else if (!strcmp(argv[ii], "-ckpt_inst")) {
+			if (ii < argc - 1) {
+				CKPT_INST = atoll(argv[ii + 1]);
+				ii += 1;
+			}
+		}
+		else if (!strcmp(argv[ii], "-ckpt_read")) {
+			if (ii < argc - 1) {
+				strcpy(CKPT_READ_FILE, argv[ii + 1]);
+				ii += 1;
+			}
+		}
+		else if (!strcmp(argv[ii], "-fanout")) {
+			if (ii < argc - 2) {
+				if (num_fanout == MAX_FANOUT) {
+					die_message("Too many -fanout configs");
+				}
+				char cwd[1024];
+				if (argv[ii + 1][0] == '/') {
+					FANOUT_CFG[num_fanout] = argv[ii + 1];
+				} else if (getcwd(cwd, sizeof(cwd)) != nullptr) {
+					FANOUT_CFG[num_fanout] = std::string(cwd) + "/" + std::string(argv[ii + 1]);
+				} else {
+					printf("getcwd() error");
+				}
+				strcpy(FANOUT_OUT[num_fanout], argv[ii + 2]);
+				num_fanout++;
+				ii += 2;
+			}
+		}
+		else if (!strcmp(argv[ii], "-fanout_jobs")) {
+			if (ii < argc - 1) {
+				FANOUT_JOBS = atoll(argv[ii + 1]);
+				ii += 1;
+			}
+		}
 		else if (!strcmp(argv[ii], "-memsize")) {
 			if (ii < argc - 1) {
 				MEM_SIZE_MB = atoi(argv[ii + 1]);
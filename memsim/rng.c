@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "externs.h"
+#include "ckpt.h"
+#include "rng.h"
+
+////////////////////////////////////////////////////////////////////
+// glibc's TYPE_3 additive feedback generator: x[i] = x[i-3] + x[i-31],
+// seeded with a Park-Miller sequence and run 310 steps before use
+////////////////////////////////////////////////////////////////////
+
+static int32_t rng_state[RNG_DEG];
+static uns     rng_front, rng_rear;
+
+
+void rng_seed(uns seed)
+{
+  int32_t word;
+
+  if(seed == 0){
+    seed = 1;
+  }
+  word = rng_state[0] = (int32_t) seed;
+  for(int ii=1; ii<RNG_DEG; ii++){
+    // 16807 * word % (2^31 - 1) without overflowing 32 bits (Schrage)
+    int32_t hi = word / 127773;
+    int32_t lo = word % 127773;
+    word = 16807 * lo - 2836 * hi;
+    if(word < 0){
+      word += 2147483647;
+    }
+    rng_state[ii] = word;
+  }
+  rng_front = RNG_SEP;
+  rng_rear  = 0;
+  for(int ii=0; ii<10*RNG_DEG; ii++){
+    rng_rand();
+  }
+}
+
+
+uns rng_rand(void)
+{
+  uint32_t val = (uint32_t) rng_state[rng_front] + (uint32_t) rng_state[rng_rear];
+
+  rng_state[rng_front] = (int32_t) val;
+  rng_front = (rng_front + 1) % RNG_DEG;
+  rng_rear  = (rng_rear + 1) % RNG_DEG;
+  return val >> 1;
+}
+
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+void rng_ckpt_write(gzFile f)
+{
+  CKPT_WRITE(f, rng_state);
+  CKPT_WRITE(f, rng_front);
+  CKPT_WRITE(f, rng_rear);
+}
+
+
+void rng_ckpt_read(gzFile f)
+{
+  CKPT_READ(f, rng_state);
+  CKPT_READ(f, rng_front);
+  CKPT_READ(f, rng_rear);
+}
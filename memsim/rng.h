@@ -0,0 +1,27 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <zlib.h>
+#include "global_types.h"
+
+
+//////////////////////////////////////////////////////////////////////////////
+// The front end's random draws (victim picks in the LLC and the OS page
+// allocator). Same sequence as glibc srand()/rand(), but the state is ours,
+// so checkpoints save it and writing one leaves the run it is taken from
+// untouched.
+//////////////////////////////////////////////////////////////////////////////
+
+#define RNG_DEG   31
+#define RNG_SEP   3
+
+void    rng_seed(uns seed);
+uns     rng_rand(void);
+
+void    rng_ckpt_write(gzFile f);
+void    rng_ckpt_read(gzFile f);
+
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#endif // RNG_H
@@ -8,6 +8,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include "global_types.h"
 #include "mcore.h"
@@ -19,6 +21,8 @@
 #endif
 
 #include "params.h"
+#include "ckpt.h"
+#include "rng.h"
 
 
 
@@ -30,6 +34,9 @@ MemSys      *memsys;
 OS          *os;
 MCache      *LLC;
 MCore       *mcore[MAX_THREADS];
+#ifdef DRAMSIM3
+double      leap_operation = 0;
+#endif
 
 
 
@@ -85,6 +92,148 @@ void print_dots()
 }
 
 
+/***************************************************************************************
+ * Checkpoints: the random generator, the front end (OS, LLC, cores) and the memory
+ * system, in that order.
+ ***************************************************************************************/
+
+Flag sim_ckpt_due()
+{
+  for(int ii=0; ii<num_threads; ii++){
+    if(mcore[ii]->lifetime_inst_count + mcore[ii]->inst_num < CKPT_INST){
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+
+void sim_ckpt_write(char *fname)
+{
+#ifdef DRAMSIM3
+  gzFile f = ckpt_open(fname, "wb1");
+  uns64  params[] = {CKPT_VERSION, (uns64)num_threads, ROB_SIZE, CORE_WIDTH, LINESIZE, OS_PAGESIZE};
+
+  ckpt_write(f, CKPT_MAGIC, 8);
+  CKPT_WRITE(f, params);
+  CKPT_WRITE(f, cycle);
+  CKPT_WRITE(f, last_printdot_cycle);
+  CKPT_WRITE(f, leap_operation);
+
+  rng_ckpt_write(f);
+  os_ckpt_write(os, f);
+  mcache_ckpt_write(LLC, f);
+  for(int ii=0; ii<num_threads; ii++){
+    mcore_ckpt_write(mcore[ii], f);
+  }
+  memsys_ckpt_write(memsys, f);
+  ckpt_close(f);
+
+  printf("\nCheckpoint written to %s at cycle %llu\n", fname, cycle);
+#else
+  die_message("Checkpoints need the DRAMsim3 memory system");
+#endif
+}
+
+
+void sim_ckpt_read(char *fname)
+{
+#ifdef DRAMSIM3
+  gzFile f = ckpt_open(fname, "rb");
+  uns64  params[] = {CKPT_VERSION, (uns64)num_threads, ROB_SIZE, CORE_WIDTH, LINESIZE, OS_PAGESIZE};
+  uns64  saved_params[sizeof(params)/sizeof(params[0])];
+  char   magic[8];
+
+  CKPT_READ(f, magic);
+  if(memcmp(magic, CKPT_MAGIC, 8)){
+    die_message("Not a checkpoint file");
+  }
+  CKPT_READ(f, saved_params);
+  if(memcmp(params, saved_params, sizeof(params))){
+    die_message("Checkpoint was taken with different core parameters");
+  }
+  CKPT_READ(f, cycle);
+  CKPT_READ(f, last_printdot_cycle);
+  CKPT_READ(f, leap_operation);
+
+  rng_ckpt_read(f);
+  os_ckpt_read(os, f);
+  mcache_ckpt_read(LLC, f);
+  for(int ii=0; ii<num_threads; ii++){
+    mcore_ckpt_read(mcore[ii], f);
+  }
+  memsys_ckpt_read(memsys, f);
+  ckpt_close(f);
+
+  printf("Restored checkpoint %s at cycle %llu\n", fname, cycle);
+#else
+  die_message("Checkpoints need the DRAMsim3 memory system");
+#endif
+}
+
+
+/***************************************************************************************
+ * Fan-out: once warmed up, fork a child per -fanout config, which continues with
+ * copy-on-write front end state. A child of the warmed up config keeps the memory system
+ * as it is, any other starts it cold. The parent only waits, running at most -fanout_jobs
+ * children at a time.
+ ***************************************************************************************/
+
+void sim_fanout()
+{
+#ifdef DRAMSIM3
+  pid_t pids[MAX_FANOUT];
+  int   ii, next = 0, running = 0, failed = 0;
+  uns64 jobs = FANOUT_JOBS ? FANOUT_JOBS : (uns64) sysconf(_SC_NPROCESSORS_ONLN);
+
+  printf("\nForking %d DRAMsim3 configs at cycle %llu\n", num_fanout, cycle);
+  fflush(stdout);
+  fflush(stderr);
+  memsys_fork_prepare(memsys); // the parent only waits from here on
+
+  while(next < num_fanout || running){
+    if(next < num_fanout && (uns64) running < jobs){
+      pids[next] = fork();
+      if(pids[next] < 0){
+        die_message("Unable to fork");
+      }
+      if(pids[next] == 0){
+        if(freopen(FANOUT_OUT[next], "w", stdout) == NULL){
+          die_message("Unable to open the -fanout output file");
+        }
+        dup2(fileno(stdout), fileno(stderr));
+        DRAMSIM3CFG = FANOUT_CFG[next];
+        memsys_fork_child(memsys);
+        printf("Forked off the warmed up run at cycle %llu\n", cycle);
+        return;
+      }
+      next++;
+      running++;
+      continue;
+    }
+
+    int   status;
+    pid_t pid = wait(&status);
+    if(pid < 0){
+      die_message("Lost the -fanout runs");
+    }
+    for(ii=0; ii<next && pids[ii] != pid; ii++);
+    if(ii == next){
+      continue;
+    }
+    Flag ok = WIFEXITED(status) && !WEXITSTATUS(status);
+    printf("%s -> %s : %s\n", FANOUT_CFG[ii].c_str(), FANOUT_OUT[ii], ok ? "done" : "FAILED");
+    fflush(stdout);
+    failed += !ok;
+    running--;
+  }
+  exit(failed ? 1 : 0);
+#else
+  die_message("Fan-out needs the DRAMsim3 memory system");
+#endif
+}
+
+
 /***************************************************************************************
  * Main
  ***************************************************************************************/
@@ -114,7 +263,12 @@ int main(int argc, char** argv)
     mcore[ii] = mcore_new( memsys, os, LLC, addr_trace_filename[ii], ii);
   }
   
-  srand(RAND_SEED);
+  rng_seed(RAND_SEED);
+
+  if(CKPT_READ_FILE[0])
+  {
+    sim_ckpt_read(CKPT_READ_FILE);
+  }
   print_dots();
 
   //--------------------------------------------------------------------
@@ -124,8 +278,9 @@ int main(int argc, char** argv)
 #ifdef DRAMSIM3
   // double CLOCK_SCALE = (4.0/2.4) - 1;
   double CLOCK_SCALE = (4.0/3.0) - 1;
-  double leap_operation = 0;
 #endif
+  Flag ckpt_pending = (CKPT_WRITE_FILE[0] != 0);
+  Flag fanout_pending = (num_fanout > 0);
   while(!(all_cores_done))
   {
     all_cores_done=1;
@@ -159,6 +314,19 @@ int main(int argc, char** argv)
     }
       
     cycle++;
+
+    if((ckpt_pending || fanout_pending) && sim_ckpt_due())
+    {
+      if(ckpt_pending)
+      {
+        sim_ckpt_write(CKPT_WRITE_FILE);
+      }
+      if(fanout_pending)
+      {
+        sim_fanout(); // only the children come back
+      }
+      ckpt_pending = fanout_pending = FALSE;
+    }
   }
     
   //--------------------------------------------------------------------
@@ -0,0 +1,770 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "externs.h"
+#include "trace.h"
+
+static Trace *open_traces = NULL;
+
+static Trace *trace_new(char *fname, uns id);
+static void   trace_map_native(Trace *t, int fd);
+static void   trace_delete(Trace *t);
+static void   trace_start_helper(Trace *t);
+static void   trace_stop_helper(Trace *t);
+static void   trace_fork_prepare(void);
+static void   trace_fork_parent(void);
+static void   trace_fork_child(void);
+static void   trace_reopen_gz(const char *fname, int fd, off_t offset);
+static void   trace_seek_block(TraceCursor *tc, uns block);
+static void   trace_free_behind(Trace *t);
+static void   trace_detach(TraceCursor *tc);
+static void   trace_own_block(TraceCursor *tc, uns block);
+static void  *trace_helper_loop(void *arg);
+static uns    trace_fill_block(gzFile gz, uns8 *raw, TraceRecord *recs, Flag *eof);
+static uns    trace_load_block(Trace *t, uns block, TraceRecord *recs, uns8 *raw);
+
+////////////////////////////////////////////////////////////////////
+// Cores opening the same file share one decoded trace
+////////////////////////////////////////////////////////////////////
+
+TraceCursor *trace_open(char *fname, uns id)
+{
+  Trace *t = open_traces;
+  while(t && strcmp(t->fname, fname))
+  {
+    t = t->next;
+  }
+  if(t == NULL)
+  {
+    if(open_traces == NULL)
+    {
+      pthread_atfork(trace_fork_prepare, trace_fork_parent, trace_fork_child);
+    }
+    t = trace_new(fname, id);
+    t->next = open_traces;
+    open_traces = t;
+  }
+  t->refs++;
+
+  TraceCursor *tc = (TraceCursor *) calloc (1, sizeof (TraceCursor));
+  tc->trace = t;
+  tc->fd    = -1;
+  tc->next  = t->cursors;
+  t->cursors = tc;
+  return tc;
+}
+
+
+////////////////////////////////////////////////////////////////////
+// Slow path of trace_read(): move on to the next block, waiting
+// for the helper if it is not decoded yet
+////////////////////////////////////////////////////////////////////
+
+Flag trace_read_block(TraceCursor *tc, TraceRecord *rec)
+{
+  while(tc->pos == tc->num)
+  {
+    if(tc->recs == NULL)
+    {
+      trace_seek_block(tc, 0);
+    }
+    else if(tc->eof)
+    {
+      memset(rec, 0, sizeof (TraceRecord));
+      return FALSE;
+    }
+    else
+    {
+      trace_seek_block(tc, tc->block + 1);
+    }
+  }
+
+  *rec = tc->recs[tc->pos++];
+  return TRUE;
+}
+
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+void trace_rewind(TraceCursor *tc)
+{
+  trace_seek_block(tc, 0);
+}
+
+
+////////////////////////////////////////////////////////////////////
+// Cursor position as a record offset, which does not depend on how
+// the file is cut into blocks (all blocks but the last are full)
+////////////////////////////////////////////////////////////////////
+
+uns64 trace_tell(TraceCursor *tc)
+{
+  if(tc->recs == NULL)
+  {
+    return 0;
+  }
+  return (uns64) tc->block * tc->trace->block_records + tc->pos;
+}
+
+
+// an offset at the end of a block stays in it, as trace_tell() gives
+void trace_seek(TraceCursor *tc, uns64 offset)
+{
+  Trace *t = tc->trace;
+  uns64 block = offset / t->block_records;
+  if(block > 0 && offset % t->block_records == 0)
+  {
+    block--;
+  }
+  if(t->map && block >= t->max_blocks)
+  {
+    die_message("Checkpoint is past the end of the input trace file. Dying ...\n");
+  }
+  trace_seek_block(tc, block);
+  offset -= block * t->block_records;
+  if(offset > tc->num)
+  {
+    die_message("Checkpoint is past the end of the input trace file. Dying ...\n");
+  }
+  tc->pos = offset;
+}
+
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+void trace_close(TraceCursor *tc)
+{
+  Trace *t = tc->trace;
+  TraceCursor **cursor = &t->cursors;
+  while(*cursor != tc)
+  {
+    cursor = &(*cursor)->next;
+  }
+  *cursor = tc->next;
+  if(tc->gz)
+  {
+    gzclose(tc->gz);
+  }
+  free(tc->own);
+  free(tc->raw);
+  free(tc);
+
+  if(--t->refs)
+  {
+    trace_free_behind(t);
+    return;
+  }
+
+  Trace **link = &open_traces;
+  while(*link != t)
+  {
+    link = &(*link)->next;
+  }
+  *link = t->next;
+  trace_delete(t);
+}
+
+
+////////////////////////////////////////////////////////////////////
+// Records on disk are little endian, as is the host
+////////////////////////////////////////////////////////////////////
+
+void trace_decode_records(TraceRecord *recs, const uns8 *src, uns num)
+{
+  for(uns ii = 0; ii < num; ii++, src += TRACE_RECORD_BYTES)
+  {
+    TraceRecord *r = &recs[ii];
+    r->inst_num = 0;
+    memcpy(&r->inst_num, src, 5);
+    r->wb = src[5];
+    memcpy(&r->va, src + 6, 4);
+  }
+}
+
+
+void trace_encode_records(uns8 *dst, const TraceRecord *recs, uns num, uns record_bytes)
+{
+  for(uns ii = 0; ii < num; ii++, dst += record_bytes)
+  {
+    if(record_bytes == sizeof (TraceRecord))
+    {
+      TraceRecord r;
+      memset(&r, 0, sizeof (TraceRecord));
+      r.inst_num = recs[ii].inst_num;
+      r.va = recs[ii].va;
+      r.wb = recs[ii].wb;
+      memcpy(dst, &r, sizeof (TraceRecord));
+    }
+    else
+    {
+      memcpy(dst, &recs[ii].inst_num, 5);
+      dst[5] = recs[ii].wb;
+      memcpy(dst + 6, &recs[ii].va, 4);
+    }
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+static Trace *trace_new(char *fname, uns id)
+{
+  Trace *t = (Trace *) calloc (1, sizeof (Trace));
+  strcpy(t->fname, fname);
+
+  int fd;
+  t->fd = -1;
+  if ((fd = open(t->fname, O_RDONLY)) < 0)
+  {
+    //---- maybe put random sleep and try again?
+    printf("Problems initializing Core: %u ... Trying again\n", id);
+    sleep(rand()%10);
+    if ((fd = open(t->fname, O_RDONLY)) < 0)
+    {
+      die_message("Unable to open the input trace file. Dying ...\n");
+    }
+  }
+
+  pthread_mutex_init(&t->lock, NULL);
+  pthread_cond_init(&t->cond, NULL);
+
+  TraceFileHeader hdr;
+  if(pread(fd, &hdr, sizeof (hdr), 0) == (ssize_t) sizeof (hdr) &&
+     !memcmp(hdr.magic, TRACE_FILE_MAGIC, sizeof (hdr.magic)))
+  {
+    trace_map_native(t, fd);
+    if(t->num_blocks == t->max_blocks)
+    {
+      return t; // used in place, nothing left to decode
+    }
+  }
+  else
+  {
+    if ((t->gz = gzdopen(fd, "r")) == NULL)
+    {
+      die_message("Unable to open the input trace file. Dying ...\n");
+    }
+    t->fd = fd;
+    gzbuffer(t->gz, 256*1024);
+    t->block_records = TRACE_BLOCK_RECORDS;
+    t->raw        = (uns8 *) malloc (TRACE_BLOCK_RECORDS * TRACE_RECORD_BYTES);
+    t->max_blocks = TRACE_MAX_BLOCKS;
+    t->blocks     = (TraceBlock *) calloc (t->max_blocks, sizeof (TraceBlock));
+    assert(t->raw && t->blocks);
+  }
+
+  trace_start_helper(t);
+
+  return t;
+}
+
+
+////////////////////////////////////////////////////////////////////
+// Map a native trace file, shared with every other process
+// reading it. Blocks of uncompressed 16B records are ready as is.
+////////////////////////////////////////////////////////////////////
+
+static void trace_map_native(Trace *t, int fd)
+{
+  struct stat st;
+  if(fstat(fd, &st) != 0)
+  {
+    die_message("Unable to stat the input trace file. Dying ...\n");
+  }
+  t->map_bytes = st.st_size;
+  void *map = mmap(NULL, t->map_bytes, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED)
+  {
+    die_message("Unable to map the input trace file. Dying ...\n");
+  }
+  t->map = (const uns8 *) map;
+  madvise(map, t->map_bytes, MADV_SEQUENTIAL);
+
+  const TraceFileHeader *hdr = (const TraceFileHeader *) t->map;
+  uns64 data_bytes = hdr->num_records * hdr->record_bytes;
+  uns64 min_blocks = hdr->block_records ? (hdr->num_records + hdr->block_records - 1) / hdr->block_records : 0;
+  if(hdr->version != TRACE_FILE_VERSION ||
+     (hdr->record_bytes != TRACE_RECORD_BYTES && hdr->record_bytes != sizeof (TraceRecord)) ||
+     hdr->block_records == 0 || hdr->num_blocks == 0 ||
+     hdr->num_blocks != (min_blocks ? min_blocks : 1) ||
+     (hdr->index_offset == 0 && sizeof (TraceFileHeader) + data_bytes > t->map_bytes) ||
+     (hdr->index_offset != 0 &&
+      hdr->index_offset + hdr->num_blocks * sizeof (TraceFileBlock) > t->map_bytes))
+  {
+    die_message("Corrupt input trace file header. Dying ...\n");
+  }
+  t->hdr        = hdr;
+  t->block_records = hdr->block_records;
+  t->index      = hdr->index_offset ? (const TraceFileBlock *) (t->map + hdr->index_offset) : NULL;
+  t->max_blocks = hdr->num_blocks;
+  t->blocks     = (TraceBlock *) calloc (t->max_blocks, sizeof (TraceBlock));
+  assert(t->blocks);
+
+  if(t->index == NULL && hdr->record_bytes == sizeof (TraceRecord))
+  {
+    const TraceRecord *recs = (const TraceRecord *) (t->map + sizeof (TraceFileHeader));
+    for(uns ii = 0; ii < t->max_blocks; ii++)
+    {
+      TraceBlock *b = &t->blocks[ii];
+      b->recs = recs + (uns64) ii * hdr->block_records;
+      b->num  = (ii + 1 < t->max_blocks) ? hdr->block_records
+                : hdr->num_records - (uns64) ii * hdr->block_records;
+      b->eof  = (ii + 1 == t->max_blocks);
+    }
+    t->num_blocks = t->max_blocks;
+  }
+  else
+  {
+    t->raw = (uns8 *) malloc ((size_t) hdr->block_records * hdr->record_bytes);
+    assert(t->raw);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+static void trace_delete(Trace *t)
+{
+  trace_stop_helper(t);
+
+  if(t->gz)
+  {
+    gzclose(t->gz);
+  }
+  if(t->map)
+  {
+    munmap((void *) t->map, t->map_bytes);
+  }
+  for(uns ii = t->first_block; ii < t->num_blocks; ii++)
+  {
+    if(t->blocks[ii].owned)
+    {
+      free((void *) t->blocks[ii].recs);
+    }
+  }
+  pthread_mutex_destroy(&t->lock);
+  pthread_cond_destroy(&t->cond);
+  free(t->raw);
+  free(t->blocks);
+  free(t);
+}
+
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+static void trace_start_helper(Trace *t)
+{
+  t->stop = FALSE;
+  if(pthread_create(&t->helper, NULL, trace_helper_loop, t) != 0)
+  {
+    die_message("Unable to start the trace reader thread. Dying ...\n");
+  }
+  t->has_helper = TRUE;
+}
+
+
+// the helper only looks at stop between blocks, so it can be started
+// again later from where it left off
+static void trace_stop_helper(Trace *t)
+{
+  if(!t->has_helper)
+  {
+    return;
+  }
+  pthread_mutex_lock(&t->lock);
+  t->stop = TRUE;
+  pthread_cond_broadcast(&t->cond);
+  pthread_mutex_unlock(&t->lock);
+  pthread_join(t->helper, NULL);
+  t->has_helper = FALSE;
+}
+
+
+static Flag trace_fully_decoded(Trace *t)
+{
+  return t->num_blocks && t->blocks[t->num_blocks - 1].eof;
+}
+
+
+////////////////////////////////////////////////////////////////////
+// fork(): the helpers are stopped around it so no lock is held and
+// no block is half decoded in the child, which has to start its own.
+// A child also gets its own descriptors for the .mtf.gz streams, at
+// the offsets they are at, the shared ones would move under the other
+// processes reading them.
+////////////////////////////////////////////////////////////////////
+
+static void trace_fork_prepare(void)
+{
+  for(Trace *t = open_traces; t; t = t->next)
+  {
+    trace_stop_helper(t);
+    if(t->gz)
+    {
+      t->fork_offset = lseek(t->fd, 0, SEEK_CUR);
+    }
+    for(TraceCursor *tc = t->cursors; tc; tc = tc->next)
+    {
+      if(tc->gz)
+      {
+        tc->fork_offset = lseek(tc->fd, 0, SEEK_CUR);
+      }
+    }
+  }
+}
+
+
+static void trace_fork_parent(void)
+{
+  for(Trace *t = open_traces; t; t = t->next)
+  {
+    if(!trace_fully_decoded(t))
+    {
+      trace_start_helper(t);
+    }
+  }
+}
+
+
+static void trace_fork_child(void)
+{
+  for(Trace *t = open_traces; t; t = t->next)
+  {
+    if(t->gz)
+    {
+      trace_reopen_gz(t->fname, t->fd, t->fork_offset);
+    }
+    for(TraceCursor *tc = t->cursors; tc; tc = tc->next)
+    {
+      if(tc->gz)
+      {
+        trace_reopen_gz(t->fname, tc->fd, tc->fork_offset);
+      }
+    }
+    if(!trace_fully_decoded(t))
+    {
+      trace_start_helper(t);
+    }
+  }
+}
+
+
+// fd becomes a descriptor of its own, at offset
+static void trace_reopen_gz(const char *fname, int fd, off_t offset)
+{
+  int new_fd = open(fname, O_RDONLY);
+  if(new_fd < 0 || lseek(new_fd, offset, SEEK_SET) != offset || dup2(new_fd, fd) < 0)
+  {
+    die_message("Unable to reopen the input trace file. Dying ...\n");
+  }
+  close(new_fd);
+}
+
+
+////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////
+
+static void trace_seek_block(TraceCursor *tc, uns block)
+{
+  Trace *t = tc->trace;
+
+  if(!tc->detached && block < t->first_block)
+  {
+    trace_detach(tc);
+    trace_free_behind(t);
+  }
+  if(tc->detached)
+  {
+    trace_own_block(tc, block);
+    return;
+  }
+
+  if(block >= tc->ready)
+  {
+    pthread_mutex_lock(&t->lock);
+    if(block > t->want_block)
+    {
+      t->want_block = block;
+      pthread_cond_broadcast(&t->cond);
+    }
+    while(t->num_blocks <= block)
+    {
+      pthread_cond_wait(&t->cond, &t->lock);
+    }
+    tc->ready = t->num_blocks;
+    pthread_mutex_unlock(&t->lock);
+  }
+
+  TraceBlock *b = &t->blocks[block];
+  tc->block = block;
+  tc->recs  = b->recs;
+  tc->num   = b->num;
+  tc->pos   = 0;
+  tc->eof   = b->eof;
+
+  trace_free_behind(t);
+}
+
+
+////////////////////////////////////////////////////////////////////
+// Free the blocks no cursor needs any more. A cursor lagging too far
+// behind the furthest one is detached first, so it does not hold on
+// to all the blocks in between. The helper only writes blocks from
+// num_blocks on, so these can go without taking the lock.
+////////////////////////////////////////////////////////////////////
+
+static void trace_free_behind(Trace *t)
+{
+  if(t->raw == NULL)
+  {
+    return; // used in place from the map
+  }
+
+  uns furthest = 0;
+  for(TraceCursor *tc = t->cursors; tc; tc = tc->next)
+  {
+    if(!tc->detached && tc->recs && tc->block > furthest)
+    {
+      furthest = tc->block;
+    }
+  }
+
+  uns keep = t->num_blocks;
+  for(TraceCursor *tc = t->cursors; tc; tc = tc->next)
+  {
+    if(tc->detached)
+    {
+      continue;
+    }
+    uns block = tc->recs ? tc->block : 0; // not started yet
+    if(furthest - block > TRACE_SHARED_BLOCKS)
+    {
+      trace_detach(tc);
+    }
+    else if(block < keep)
+    {
+      keep = block;
+    }
+  }
+
+  for(; t->first_block < keep; t->first_block++)
+  {
+    TraceBlock *b = &t->blocks[t->first_block];
+    if(b->owned)
+    {
+      free((void *) b->recs);
+      b->recs = NULL;
+    }
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////
+// From now on the cursor decodes its own blocks, starting with a copy
+// of the current one
+////////////////////////////////////////////////////////////////////
+
+static void trace_detach(TraceCursor *tc)
+{
+  Trace *t = tc->trace;
+  uns record_bytes = t->hdr ? t->hdr->record_bytes : TRACE_RECORD_BYTES;
+
+  tc->detached = TRUE;
+  tc->own = (TraceRecord *) malloc (t->block_records * sizeof (TraceRecord));
+  tc->raw = (uns8 *) malloc ((size_t) t->block_records * record_bytes);
+  assert(tc->own && tc->raw);
+  if(tc->recs)
+  {
+    memcpy(tc->own, tc->recs, tc->num * sizeof (TraceRecord));
+    tc->recs = tc->own;
+  }
+
+  if(t->map == NULL)
+  {
+    if((tc->fd = open(t->fname, O_RDONLY)) < 0 || (tc->gz = gzdopen(tc->fd, "r")) == NULL)
+    {
+      die_message("Unable to open the input trace file. Dying ...\n");
+    }
+    gzbuffer(tc->gz, 256*1024);
+    tc->gz_block = 0;
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////
+// Block of a detached cursor. A .mtf.gz stream cannot be read from
+// any block, going somewhere else than the next one means inflating
+// the trace again up to there.
+////////////////////////////////////////////////////////////////////
+
+static void trace_own_block(TraceCursor *tc, uns block)
+{
+  Trace *t = tc->trace;
+  Flag  eof;
+  uns   num;
+
+  if(t->map)
+  {
+    num = trace_load_block(t, block, tc->own, tc->raw);
+    eof = (block + 1 == t->max_blocks);
+  }
+  else
+  {
+    if(tc->gz_block != block)
+    {
+      z_off_t offset = (z_off_t) block * TRACE_BLOCK_RECORDS * TRACE_RECORD_BYTES;
+      if(gzseek(tc->gz, offset, SEEK_SET) != offset)
+      {
+        die_message("Unable to read the input trace file. Dying ...\n");
+      }
+    }
+    num = trace_fill_block(tc->gz, tc->raw, tc->own, &eof);
+    tc->gz_block = block + 1;
+  }
+
+  tc->block = block;
+  tc->recs  = tc->own;
+  tc->num   = num;
+  tc->pos   = 0;
+  tc->eof   = eof;
+}
+
+
+////////////////////////////////////////////////////////////////////
+// Helper thread: decode up to TRACE_READ_AHEAD blocks past the
+// furthest cursor, until the end of the stream or until asked to
+// stop
+////////////////////////////////////////////////////////////////////
+
+static void *trace_helper_loop(void *arg)
+{
+  Trace *t = (Trace *) arg;
+
+  while(1)
+  {
+    pthread_mutex_lock(&t->lock);
+    while(t->num_blocks > t->want_block + TRACE_READ_AHEAD && !t->stop)
+    {
+      pthread_cond_wait(&t->cond, &t->lock);
+    }
+    Flag stop = t->stop;
+    uns  next = t->num_blocks;
+    pthread_mutex_unlock(&t->lock);
+    if(stop)
+    {
+      return NULL;
+    }
+
+    TraceBlock  *b = &t->blocks[next];
+    TraceRecord *recs = (TraceRecord *) malloc (t->block_records * sizeof (TraceRecord));
+    assert(recs);
+    if(t->gz)
+    {
+      if(next == t->max_blocks)
+      {
+        die_message("Input trace file is too long. Dying ...\n");
+      }
+      b->num = trace_fill_block(t->gz, t->raw, recs, &b->eof);
+    }
+    else
+    {
+      b->num = trace_load_block(t, next, recs, t->raw);
+      b->eof = (next + 1 == t->max_blocks);
+    }
+    b->recs  = recs;
+    b->owned = TRUE;
+
+    pthread_mutex_lock(&t->lock);
+    t->num_blocks++;
+    pthread_cond_broadcast(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+
+    if(b->eof)
+    {
+      if(t->gz)
+      {
+        gzclose(t->gz);
+        t->gz = NULL;
+      }
+      return NULL;
+    }
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////
+// gzread only returns short at the end of the stream, so a short
+// block (possibly empty) is the last one, a trailing partial
+// record is dropped the same way a short gzread was before
+////////////////////////////////////////////////////////////////////
+
+static uns trace_fill_block(gzFile gz, uns8 *raw, TraceRecord *recs, Flag *eof)
+{
+  int want  = TRACE_BLOCK_RECORDS * TRACE_RECORD_BYTES;
+  int bytes = gzread(gz, raw, want);
+  if(bytes < 0)
+  {
+    die_message("Unable to read the input trace file. Dying ...\n");
+  }
+
+  uns num = bytes / TRACE_RECORD_BYTES;
+  *eof = (bytes < want);
+  trace_decode_records(recs, raw, num);
+  return num;
+}
+
+
+////////////////////////////////////////////////////////////////////
+// Block of a native file, inflated into raw first if compressed. The
+// index entry is all it takes to find it.
+////////////////////////////////////////////////////////////////////
+
+static uns trace_load_block(Trace *t, uns block, TraceRecord *recs, uns8 *raw)
+{
+  const TraceFileHeader *hdr = t->hdr;
+  const uns8 *src;
+  uns num;
+
+  if(t->index)
+  {
+    const TraceFileBlock *fb = &t->index[block];
+    uLongf bytes = (uLongf) fb->records * hdr->record_bytes;
+    if(fb->records > hdr->block_records || fb->offset + fb->bytes > t->map_bytes ||
+       uncompress(raw, &bytes, t->map + fb->offset, fb->bytes) != Z_OK ||
+       bytes != (uLongf) fb->records * hdr->record_bytes)
+    {
+      die_message("Corrupt block in the input trace file. Dying ...\n");
+    }
+    src = raw;
+    num = fb->records;
+  }
+  else
+  {
+    src = t->map + sizeof (TraceFileHeader) + (uns64) block * hdr->block_records * hdr->record_bytes;
+    num = (block + 1 < t->max_blocks) ? hdr->block_records
+          : hdr->num_records - (uns64) block * hdr->block_records;
+  }
+
+  if(hdr->record_bytes == sizeof (TraceRecord))
+  {
+    memcpy(recs, src, num * sizeof (TraceRecord));
+  }
+  else
+  {
+    trace_decode_records(recs, src, num);
+  }
+  return num;
+}
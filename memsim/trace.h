@@ -0,0 +1,163 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <zlib.h>
+#include "global_types.h"
+
+
+#define TRACE_RECORD_BYTES   10   // packed .mtf record: 5B inst_num, 1B wb, 4B va
+#define TRACE_BLOCK_RECORDS  (64*1024)
+#define TRACE_MAX_BLOCKS     (64*1024)
+#define TRACE_READ_AHEAD     1    // blocks decoded past the furthest cursor
+#define TRACE_SHARED_BLOCKS  16   // furthest a cursor can lag the others and still share blocks
+
+#define TRACE_FILE_MAGIC     "MTFBLK1"
+#define TRACE_FILE_VERSION   1
+
+typedef struct TraceRecord     TraceRecord;
+typedef struct TraceBlock      TraceBlock;
+typedef struct TraceFileHeader TraceFileHeader;
+typedef struct TraceFileBlock  TraceFileBlock;
+typedef struct Trace           Trace;
+typedef struct TraceCursor     TraceCursor;
+
+
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+// also the 16B record of the native format, padding written as zero
+struct TraceRecord
+{
+  uns64 inst_num;
+  uns32 va;
+  Flag  wb;
+};
+
+
+struct TraceBlock
+{
+  const TraceRecord *recs;
+  uns   num;
+  Flag  eof;   // the stream ended within (or right after) this block
+  Flag  owned; // recs were decoded into memory, not mapped from the file
+};
+
+
+// Native trace file (see trace_convert.c): this header, then the records
+// in blocks of block_records. Without compression the blocks follow the
+// header back to back, so a file of 16B records is used in place from the
+// page cache. With compression every block is deflated on its own and
+// index_offset points to num_blocks TraceFileBlock entries, so any block
+// can be located and inflated without reading the ones before it.
+struct TraceFileHeader
+{
+  char  magic[8];
+  uns32 version;
+  uns32 record_bytes;  // 10 (packed .mtf record) or 16 (TraceRecord)
+  uns32 block_records;
+  uns32 num_blocks;
+  uns64 num_records;
+  uns64 index_offset;  // 0 when the blocks are not compressed
+  uns64 reserved[3];   // keeps the records 64B aligned
+};
+
+
+struct TraceFileBlock
+{
+  uns64 offset;
+  uns32 bytes;   // compressed size
+  uns32 records;
+};
+
+
+// Decoded address trace, shared by all the cores opened on the same file
+// (e.g. in rate mode). Either a .mtf.gz file or a native trace file, told
+// apart by the header. Unless every block can be used in place, a helper
+// thread decodes a block at a time, staying TRACE_READ_AHEAD blocks ahead
+// of the furthest cursor. Blocks are freed once every cursor is past them.
+// A cursor that needs a freed block (after a rewind or a seek) or that
+// lags more than TRACE_SHARED_BLOCKS behind the furthest one is detached:
+// from then on it decodes its own blocks, one at a time.
+struct Trace
+{
+  char    fname[1024];
+  uns     refs;
+  Trace  *next; // open traces
+
+  gzFile  gz;      // .mtf.gz file
+  int     fd;      // ... and its descriptor
+  off_t   fork_offset;
+  const uns8 *map; // native file
+  size_t  map_bytes;
+  const TraceFileHeader *hdr;
+  const TraceFileBlock  *index;
+  uns8   *raw; // a block is inflated here before decoding, NULL if used in place
+  uns     block_records;  // records in every block but the last
+
+  TraceCursor *cursors;   // open on this trace
+  TraceBlock *blocks;     // max_blocks
+  uns     max_blocks;
+  uns     first_block;    // blocks before it were freed
+  uns     num_blocks;     // decoded so far, guarded by lock
+  uns     want_block;     // furthest block asked for by a cursor, guarded by lock
+  Flag    stop;           // ask the helper to quit, guarded by lock
+
+  Flag            has_helper;
+  pthread_t       helper;
+  pthread_mutex_t lock;
+  pthread_cond_t  cond;
+};
+
+
+// A core's position in a shared trace
+struct TraceCursor
+{
+  Trace  *trace;
+  TraceCursor *next; // cursors of the trace
+  const TraceRecord *recs; // records of the current block
+  uns     num;   // records in the current block
+  uns     pos;   // next record in the current block
+  uns     block; // current block
+  uns     ready; // blocks known to be decoded
+  Flag    eof;   // current block is the last one
+
+  Flag    detached;  // decodes its own blocks
+  TraceRecord *own;  // ... into here
+  uns8   *raw;
+  gzFile  gz;        // detached from a .mtf.gz trace: its own stream
+  int     fd;        // ... and its descriptor
+  off_t   fork_offset;
+  uns     gz_block;  // block the stream is at
+};
+
+
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+TraceCursor *trace_open(char *fname, uns id);
+Flag    trace_read_block(TraceCursor *tc, TraceRecord *rec);
+void    trace_rewind(TraceCursor *tc);
+uns64   trace_tell(TraceCursor *tc);
+void    trace_seek(TraceCursor *tc, uns64 offset);
+void    trace_close(TraceCursor *tc);
+
+void    trace_decode_records(TraceRecord *recs, const uns8 *src, uns num);
+void    trace_encode_records(uns8 *dst, const TraceRecord *recs, uns num, uns record_bytes);
+
+// next record of the trace, FALSE (and a zeroed record) once past its end
+static inline Flag trace_read(TraceCursor *tc, TraceRecord *rec)
+{
+  if(tc->pos < tc->num)
+  {
+    *rec = tc->recs[tc->pos++];
+    return TRUE;
+  }
+  return trace_read_block(tc, rec);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#endif // TRACE_H
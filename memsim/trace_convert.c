@@ -0,0 +1,141 @@
+/***************************************************************************************
+ * trace_convert: rewrite an address trace (.mtf.gz) as a native trace file
+ *
+ * By default the records are written as uncompressed 16B records, which the
+ * simulator maps and uses in place, shared through the page cache by every
+ * process running the same trace. With -z every block is deflated on its own
+ * and a block index is appended, for a smaller file that can still be read
+ * from any block.
+ ***************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "global_types.h"
+#include "trace.h"
+
+
+void die_message(const char * msg) {
+    printf("Error! %s. Exiting...\n", msg);
+    exit(1);
+}
+
+
+void die_usage() {
+    printf("Usage : trace_convert [options] <trace.mtf.gz> <trace.mtfb>\n\n");
+    printf("Rewrite an address trace as a native (mmap-able) trace file\n");
+
+    printf("   Option (examples)\n");
+    printf("               -z                    Deflate every block, add a block index (Default:off)\n");
+    printf("               -recbytes    <num>    Record size, 10 or 16 (Default: 16)\n");
+
+    exit(0);
+}
+
+
+int main(int argc, char** argv)
+{
+  Flag  compress  = FALSE;
+  uns   rec_bytes = sizeof (TraceRecord);
+  char *in_fname  = NULL;
+  char *out_fname = NULL;
+
+  for (int ii = 1; ii < argc; ii++) {
+    if (!strcmp(argv[ii], "-z")) {
+      compress = TRUE;
+    }
+    else if (!strcmp(argv[ii], "-recbytes") && ii < argc - 1) {
+      rec_bytes = atoi(argv[++ii]);
+    }
+    else if (argv[ii][0] == '-') {
+      die_usage();
+    }
+    else if (in_fname == NULL) {
+      in_fname = argv[ii];
+    }
+    else if (out_fname == NULL) {
+      out_fname = argv[ii];
+    }
+    else {
+      die_usage();
+    }
+  }
+  if (out_fname == NULL ||
+      (rec_bytes != TRACE_RECORD_BYTES && rec_bytes != sizeof (TraceRecord))) {
+    die_usage();
+  }
+
+  TraceCursor *tc = trace_open(in_fname, 0);
+  FILE *out = fopen(out_fname, "wb");
+  if (out == NULL) {
+    die_message("Unable to open the output trace file");
+  }
+
+  TraceFileHeader hdr;
+  memset(&hdr, 0, sizeof (hdr));
+  memcpy(hdr.magic, TRACE_FILE_MAGIC, sizeof (hdr.magic));
+  hdr.version       = TRACE_FILE_VERSION;
+  hdr.record_bytes  = rec_bytes;
+  hdr.block_records = TRACE_BLOCK_RECORDS;
+  fwrite(&hdr, sizeof (hdr), 1, out); // rewritten once the counts are known
+
+  uLong        raw_bytes = TRACE_BLOCK_RECORDS * rec_bytes;
+  TraceRecord *recs  = (TraceRecord *) malloc (TRACE_BLOCK_RECORDS * sizeof (TraceRecord));
+  uns8        *raw   = (uns8 *) malloc (raw_bytes);
+  uns8        *zraw  = (uns8 *) malloc (compressBound(raw_bytes));
+  TraceFileBlock *index = NULL;
+  uns64        offset = sizeof (hdr);
+  Flag         more   = TRUE;
+
+  while (more) {
+    uns num = 0;
+    while (num < TRACE_BLOCK_RECORDS && (more = trace_read(tc, &recs[num]))) {
+      num++;
+    }
+    if (num == 0 && hdr.num_blocks > 0) {
+      break;
+    }
+
+    trace_encode_records(raw, recs, num, rec_bytes);
+    uLongf bytes = num * rec_bytes;
+    const uns8 *block = raw;
+    if (compress) {
+      uLongf zbytes = compressBound(raw_bytes);
+      if (compress2(zraw, &zbytes, raw, bytes, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        die_message("Unable to compress a trace block");
+      }
+      index = (TraceFileBlock *) realloc (index, (hdr.num_blocks + 1) * sizeof (TraceFileBlock));
+      index[hdr.num_blocks].offset  = offset;
+      index[hdr.num_blocks].bytes   = zbytes;
+      index[hdr.num_blocks].records = num;
+      block = zraw;
+      bytes = zbytes;
+    }
+    fwrite(block, 1, bytes, out);
+    offset += bytes;
+    hdr.num_blocks++;
+    hdr.num_records += num;
+  }
+
+  if (compress) {
+    hdr.index_offset = offset;
+    fwrite(index, sizeof (TraceFileBlock), hdr.num_blocks, out);
+  }
+  fseek(out, 0, SEEK_SET);
+  fwrite(&hdr, sizeof (hdr), 1, out);
+  if (ferror(out) || fclose(out) != 0) {
+    die_message("Unable to write the output trace file");
+  }
+  trace_close(tc);
+
+  printf("%s: %llu records in %u blocks (%u B records%s)\n", out_fname,
+         hdr.num_records, hdr.num_blocks, rec_bytes, compress ? ", compressed" : "");
+
+  free(index);
+  free(zraw);
+  free(raw);
+  free(recs);
+  return 0;
+}